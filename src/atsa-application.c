@@ -19,15 +19,23 @@
  */
 
 #include "config.h"
+#include <stdlib.h>
 #include <glib/gi18n.h>
 #include <gtk/gtk.h> // Includes GtkFileDialog, GtkFileFilter, GListStore, etc.
 #include "atsa-application.h"
 #include "atsa-window.h"
 #include "atsa-test-window.h"
+#include "atsa-bank-format.h"
+#include "atsa-export.h"
+#include "atsa-question-bank.h"
+#include "atsa-review-window.h"
 #include "rust_questions_api.h"
 struct _AtsaApplication
 {
 	AdwApplication parent_instance;
+
+	// Shared by all windows, opened on first use
+	AtsaReviewScheduler *review_scheduler;
 };
 
 G_DEFINE_FINAL_TYPE (AtsaApplication, atsa_application, ADW_TYPE_APPLICATION)
@@ -45,6 +53,41 @@ atsa_application_new (const char        *application_id,
 	                     NULL);
 }
 
+/**
+ * atsa_application_get_review_scheduler:
+ * @self: a #AtsaApplication
+ *
+ * Gets the scheduler that every loaded question bank is added to for
+ * self-study. Its state lives in the user data directory.
+ *
+ * Returns: (transfer none) (nullable): the scheduler, or %NULL if the
+ *   review state could not be opened
+ */
+AtsaReviewScheduler *
+atsa_application_get_review_scheduler (AtsaApplication *self)
+{
+	g_return_val_if_fail (ATSA_IS_APPLICATION (self), NULL);
+
+	if (self->review_scheduler == NULL)
+	{
+		g_autofree char *path = NULL;
+		g_autoptr(GError) error = NULL;
+		AtsaReviewStore *store;
+
+		path = g_build_filename (g_get_user_data_dir (), "atsa", "review-state.db", NULL);
+		store = atsa_review_store_open (path, &error);
+		if (store == NULL)
+		{
+			g_printerr ("Failed to open review state: %s\n", error->message);
+			return NULL;
+		}
+
+		self->review_scheduler = atsa_review_scheduler_new (store);
+	}
+
+	return self->review_scheduler;
+}
+
 static void
 atsa_application_activate (GApplication *app)
 {
@@ -62,12 +105,149 @@ atsa_application_activate (GApplication *app)
 	gtk_window_present (window);
 }
 
+static const GOptionEntry main_options[] = {
+	{ "export-pdf", 0, 0, G_OPTION_ARG_FILENAME, NULL,
+	  N_("Export exam variants of a question file as PDF without opening a window"), N_("FILE") },
+	{ "variants", 0, 0, G_OPTION_ARG_INT, NULL,
+	  N_("Number of variants to export (default: 1)"), N_("N") },
+	{ "seed", 0, 0, G_OPTION_ARG_INT64, NULL,
+	  N_("Seed the variants are shuffled with (default: random)"), N_("SEED") },
+	{ "output", 'o', 0, G_OPTION_ARG_FILENAME, NULL,
+	  N_("Directory to write exported files to (default: current directory)"), N_("DIR") },
+	{ "convert", 0, 0, G_OPTION_ARG_STRING, NULL,
+	  N_("Convert the given question files to csv, json or gift without opening a window"), N_("FORMAT") },
+	{ G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, NULL,
+	  NULL, N_("[FILE…]") },
+	{ NULL }
+};
+
+// Headless export; runs before the application registers, so no display is needed.
+static int
+atsa_application_export_pdf (GVariantDict *options,
+                             const char   *path)
+{
+	g_autoptr(AtsaQuestionBank) bank = NULL;
+	g_autoptr(GError) error = NULL;
+	const char *output = ".";
+	gint32 n_variants = 1;
+	gint64 seed;
+
+	g_variant_dict_lookup (options, "output", "^&ay", &output);
+	g_variant_dict_lookup (options, "variants", "i", &n_variants);
+	if (!g_variant_dict_lookup (options, "seed", "x", &seed))
+		seed = g_random_int ();
+
+	if (n_variants < 1)
+	{
+		g_printerr (_("The number of variants must be at least 1\n"));
+		return EXIT_FAILURE;
+	}
+
+	bank = atsa_question_bank_load (path, &error);
+	if (bank == NULL ||
+	    !atsa_export_variants (bank, n_variants, (guint32) seed, output, NULL, &error))
+	{
+		g_printerr ("%s\n", error->message);
+		return EXIT_FAILURE;
+	}
+
+	g_print (g_dngettext (GETTEXT_PACKAGE,
+	                      "Exported %d variant to %s (seed %u)\n",
+	                      "Exported %d variants to %s (seed %u)\n",
+	                      n_variants),
+	         n_variants, output, (guint32) seed);
+
+	return EXIT_SUCCESS;
+}
+
+// Headless conversion between question file formats, all files at once.
+static int
+atsa_application_convert (GVariantDict *options,
+                          const char   *format_name)
+{
+	g_autofree const char **inputs = NULL;
+	g_autoptr(GError) error = NULL;
+	const char *output = ".";
+	AtsaBankFormat format;
+	guint n_inputs;
+
+	g_variant_dict_lookup (options, "output", "^&ay", &output);
+
+	format = atsa_bank_format_from_name (format_name);
+	if (format != ATSA_BANK_FORMAT_CSV &&
+	    format != ATSA_BANK_FORMAT_JSON &&
+	    format != ATSA_BANK_FORMAT_GIFT)
+	{
+		g_printerr (_("Unknown format “%s”, expected csv, json or gift\n"), format_name);
+		return EXIT_FAILURE;
+	}
+
+	if (!g_variant_dict_lookup (options, G_OPTION_REMAINING, "^a&ay", &inputs))
+	{
+		g_printerr (_("No question files to convert\n"));
+		return EXIT_FAILURE;
+	}
+
+	if (!atsa_bank_convert_files (inputs, output, format, NULL, &error))
+	{
+		g_printerr ("%s\n", error->message);
+		return EXIT_FAILURE;
+	}
+
+	n_inputs = g_strv_length ((GStrv) inputs);
+	g_print (g_dngettext (GETTEXT_PACKAGE,
+	                      "Converted %u file to %s\n",
+	                      "Converted %u files to %s\n",
+	                      n_inputs),
+	         n_inputs, output);
+
+	return EXIT_SUCCESS;
+}
+
+static int
+atsa_application_handle_local_options (GApplication *app,
+                                       GVariantDict *options)
+{
+	const char *path = NULL;
+	const char *format_name = NULL;
+
+	// Only --convert takes files, don't drop them silently otherwise
+	if (g_variant_dict_contains (options, G_OPTION_REMAINING) &&
+	    !g_variant_dict_contains (options, "convert"))
+	{
+		g_printerr (_("Question files can only be given with --convert\n"));
+		return EXIT_FAILURE;
+	}
+
+	if (g_variant_dict_lookup (options, "export-pdf", "^&ay", &path))
+		return atsa_application_export_pdf (options, path);
+
+	if (g_variant_dict_lookup (options, "convert", "&s", &format_name))
+		return atsa_application_convert (options, format_name);
+
+	// Carry on with the normal startup
+	return -1;
+}
+
+static void
+atsa_application_shutdown (GApplication *app)
+{
+	AtsaApplication *self = ATSA_APPLICATION (app);
+
+	// Flushes the review state to disk
+	g_clear_pointer (&self->review_scheduler, atsa_review_scheduler_free);
+
+	G_APPLICATION_CLASS (atsa_application_parent_class)->shutdown (app);
+}
+
 static void
 atsa_application_class_init (AtsaApplicationClass *klass)
 {
 	GApplicationClass *app_class = G_APPLICATION_CLASS (klass);
 
 	app_class->activate = atsa_application_activate;
+	app_class->shutdown = atsa_application_shutdown;
+	app_class->handle_local_options = atsa_application_handle_local_options;
 }
 
 // --- Callback for Open Folder (GtkFileDialog) completion ---
@@ -163,7 +343,7 @@ open_file_dialog_response_cb (GObject      *source_object,
     else if (file)
     {
         input_path = g_file_get_path (file);
-        g_print("Selected YAML file: %s\n", input_path);
+        g_print("Selected question file: %s\n", input_path);
 
         // NEW: Create and show the new AtsaTestWindow
         AtsaTestWindow *test_window = atsa_test_window_new(GTK_APPLICATION(app), input_path);
@@ -194,7 +374,11 @@ atsa_application_open_file_action (GSimpleAction *action,
     GtkWindow       *parent_window = NULL;
     GtkFileDialog   *dialog = NULL;
     GListStore      *filters = NULL;
+    GtkFileFilter   *questions_filter = NULL;
     GtkFileFilter   *yaml_filter = NULL;
+    GtkFileFilter   *csv_filter = NULL;
+    GtkFileFilter   *json_filter = NULL;
+    GtkFileFilter   *gift_filter = NULL;
     GtkFileFilter   *all_files_filter = NULL;
 
     g_assert (ATSA_IS_APPLICATION (self));
@@ -202,7 +386,7 @@ atsa_application_open_file_action (GSimpleAction *action,
     parent_window = gtk_application_get_active_window (GTK_APPLICATION (self));
 
     dialog = gtk_file_dialog_new ();
-    gtk_file_dialog_set_title (dialog, _("Open YAML File"));
+    gtk_file_dialog_set_title (dialog, _("Open Question File"));
 
     gtk_file_dialog_set_modal (dialog, TRUE);
 
@@ -213,17 +397,50 @@ atsa_application_open_file_action (GSimpleAction *action,
     gtk_file_filter_add_mime_type (yaml_filter, "text/yaml");
     gtk_file_filter_add_mime_type (yaml_filter, "application/x-yaml");
 
+    // CSV, JSON and GIFT files are imported on load, see atsa-bank-format.c
+    csv_filter = gtk_file_filter_new ();
+    gtk_file_filter_set_name (csv_filter, _("CSV Files"));
+    gtk_file_filter_add_pattern (csv_filter, "*.csv");
+    gtk_file_filter_add_mime_type (csv_filter, "text/csv");
+
+    json_filter = gtk_file_filter_new ();
+    gtk_file_filter_set_name (json_filter, _("JSON Files"));
+    gtk_file_filter_add_pattern (json_filter, "*.json");
+    gtk_file_filter_add_pattern (json_filter, "*.jsonl");
+    gtk_file_filter_add_mime_type (json_filter, "application/json");
+
+    gift_filter = gtk_file_filter_new ();
+    gtk_file_filter_set_name (gift_filter, _("Moodle GIFT Files"));
+    gtk_file_filter_add_pattern (gift_filter, "*.gift");
+
+    questions_filter = gtk_file_filter_new ();
+    gtk_file_filter_set_name (questions_filter, _("All Question Files"));
+    gtk_file_filter_add_pattern (questions_filter, "*.yaml");
+    gtk_file_filter_add_pattern (questions_filter, "*.yml");
+    gtk_file_filter_add_pattern (questions_filter, "*.csv");
+    gtk_file_filter_add_pattern (questions_filter, "*.json");
+    gtk_file_filter_add_pattern (questions_filter, "*.jsonl");
+    gtk_file_filter_add_pattern (questions_filter, "*.gift");
+
     all_files_filter = gtk_file_filter_new ();
     gtk_file_filter_set_name (all_files_filter, _("All Files"));
     gtk_file_filter_add_pattern (all_files_filter, "*");
 
     filters = g_list_store_new (GTK_TYPE_FILE_FILTER);
+    g_list_store_append (filters, questions_filter);
     g_list_store_append (filters, yaml_filter);
+    g_list_store_append (filters, csv_filter);
+    g_list_store_append (filters, json_filter);
+    g_list_store_append (filters, gift_filter);
     g_list_store_append (filters, all_files_filter);
 
     gtk_file_dialog_set_filters (dialog, G_LIST_MODEL (filters));
 
+    g_object_unref (questions_filter);
     g_object_unref (yaml_filter);
+    g_object_unref (csv_filter);
+    g_object_unref (json_filter);
+    g_object_unref (gift_filter);
     g_object_unref (all_files_filter);
     g_object_unref (filters);
 
@@ -231,7 +448,26 @@ atsa_application_open_file_action (GSimpleAction *action,
                           parent_window,
                           NULL,
                           open_file_dialog_response_cb,
-                          NULL);
+                          self);
+}
+
+static void
+atsa_application_review_action (GSimpleAction *action,
+                                GVariant      *parameter,
+                                gpointer       user_data)
+{
+    AtsaApplication     *self = user_data;
+    AtsaReviewScheduler *scheduler;
+    AtsaReviewWindow    *window;
+
+    g_assert (ATSA_IS_APPLICATION (self));
+
+    scheduler = atsa_application_get_review_scheduler (self);
+    if (scheduler == NULL)
+        return;
+
+    window = atsa_review_window_new (GTK_APPLICATION (self), scheduler);
+    gtk_window_present (GTK_WINDOW (window));
 }
 
 static void
@@ -275,11 +511,13 @@ static const GActionEntry app_actions[] = {
 	{ "about", atsa_application_about_action },
         { "open-project", atsa_application_open_project_action }, // Action for "Open Folder"
         { "open-file", atsa_application_open_file_action },
+        { "review", atsa_application_review_action }, // Study due questions of all loaded files
 };
 
 static void
 atsa_application_init (AtsaApplication *self)
 {
+	g_application_add_main_option_entries (G_APPLICATION (self), main_options);
 	g_action_map_add_action_entries (G_ACTION_MAP (self),
 	                                 app_actions,
 	                                 G_N_ELEMENTS (app_actions),
@@ -22,13 +22,16 @@
 
 #include <adwaita.h>
 
+#include "atsa-review-scheduler.h"
+
 G_BEGIN_DECLS
 
 #define ATSA_TYPE_APPLICATION (atsa_application_get_type())
 
 G_DECLARE_FINAL_TYPE (AtsaApplication, atsa_application, ATSA, APPLICATION, AdwApplication)
 
-AtsaApplication *atsa_application_new (const char        *application_id,
-                                       GApplicationFlags  flags);
+AtsaApplication     *atsa_application_new                  (const char        *application_id,
+                                                            GApplicationFlags  flags);
+AtsaReviewScheduler *atsa_application_get_review_scheduler (AtsaApplication   *self);
 
 G_END_DECLS
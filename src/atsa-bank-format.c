@@ -0,0 +1,1782 @@
+/* atsa-bank-format.c
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <glib/gi18n.h>
+#include <json-glib/json-glib.h>
+
+#include "atsa-bank-format.h"
+#include "atsa-worker-pool.h"
+
+/* Question banks in the formats learning management systems exchange.
+ *
+ * CSV has one question per row: type, question, answer and then one column
+ * per choice. The type is "multiple_choice" or "true_false". A multiple
+ * choice answer is a letter or a 1-based number, a true/false answer has
+ * one T or F per statement, such as "TFT". Quoted fields may span lines and
+ * a first row starting with "type" is taken as the header.
+ *
+ * JSON is an array of objects, or one object per line, with "type",
+ * "question", "choices" and either "answer", the 0-based index of the
+ * correct choice, or "answers", one boolean per statement.
+ *
+ * GIFT is the Moodle import format. Its multiple choice and true/false
+ * questions map onto ours, matching, short answer, numerical and essay
+ * questions are skipped and counted. A GIFT true/false question has a
+ * single statement, so ours are written as one GIFT question per statement
+ * with the stem on the line above it, which is how they are read back.
+ *
+ * Readers and writers handle one question at a time through buffered
+ * streams and reuse their buffers, so memory use does not depend on the
+ * size of the file. YAML goes through the Rust library, which always loads
+ * the whole file, and can only be read.
+ */
+
+#define IO_BUFFER_SIZE   (64 * 1024)
+#define UTF8_BOM         "\xEF\xBB\xBF"
+/* Random names to try for a writer's temporary file */
+#define MAX_TMP_ATTEMPTS 100
+
+typedef struct
+{
+	AtsaBankFormat  format;
+	const char     *name;
+	/* The first one is used for writing */
+	const char     *extensions[3];
+} FormatInfo;
+
+static const FormatInfo formats[] = {
+	{ ATSA_BANK_FORMAT_YAML, "yaml", { ".yaml", ".yml", NULL } },
+	{ ATSA_BANK_FORMAT_CSV,  "csv",  { ".csv", NULL } },
+	{ ATSA_BANK_FORMAT_JSON, "json", { ".json", ".jsonl", NULL } },
+	{ ATSA_BANK_FORMAT_GIFT, "gift", { ".gift", NULL } },
+};
+
+/**
+ * atsa_bank_format_from_path:
+ * @path: a file name
+ *
+ * Returns: the format of @path going by its extension
+ */
+AtsaBankFormat
+atsa_bank_format_from_path (const char *path)
+{
+	g_autofree char *lower = NULL;
+
+	g_return_val_if_fail (path != NULL, ATSA_BANK_FORMAT_UNKNOWN);
+
+	lower = g_ascii_strdown (path, -1);
+
+	for (guint i = 0; i < G_N_ELEMENTS (formats); i++)
+	{
+		for (guint j = 0; formats[i].extensions[j] != NULL; j++)
+		{
+			if (g_str_has_suffix (lower, formats[i].extensions[j]))
+				return formats[i].format;
+		}
+	}
+
+	return ATSA_BANK_FORMAT_UNKNOWN;
+}
+
+/**
+ * atsa_bank_format_from_name:
+ * @name: a format name such as "csv", in any case
+ *
+ * Returns: the format called @name
+ */
+AtsaBankFormat
+atsa_bank_format_from_name (const char *name)
+{
+	g_return_val_if_fail (name != NULL, ATSA_BANK_FORMAT_UNKNOWN);
+
+	for (guint i = 0; i < G_N_ELEMENTS (formats); i++)
+	{
+		if (g_ascii_strcasecmp (name, formats[i].name) == 0)
+			return formats[i].format;
+	}
+
+	return ATSA_BANK_FORMAT_UNKNOWN;
+}
+
+/**
+ * atsa_bank_format_get_extension:
+ * @format: a format
+ *
+ * Returns: (nullable): the file extension written for @format, without
+ *   the dot
+ */
+const char *
+atsa_bank_format_get_extension (AtsaBankFormat format)
+{
+	for (guint i = 0; i < G_N_ELEMENTS (formats); i++)
+	{
+		if (formats[i].format == format)
+			return formats[i].extensions[0] + 1;
+	}
+
+	return NULL;
+}
+
+static gboolean
+format_is_writable (AtsaBankFormat format)
+{
+	return format == ATSA_BANK_FORMAT_CSV ||
+	       format == ATSA_BANK_FORMAT_JSON ||
+	       format == ATSA_BANK_FORMAT_GIFT;
+}
+
+static const char *
+question_type_to_string (QuestionTypeC type)
+{
+	switch (type)
+	{
+	case QUESTION_TYPE_MULTIPLE_CHOICE:
+		return "multiple_choice";
+
+	case QUESTION_TYPE_TRUE_FALSE:
+		return "true_false";
+
+	case QUESTION_TYPE_NONE:
+	default:
+		return NULL;
+	}
+}
+
+static gboolean
+question_type_from_string (const char    *string,
+                           QuestionTypeC *type)
+{
+	if (g_ascii_strcasecmp (string, "multiple_choice") == 0 ||
+	    g_ascii_strcasecmp (string, "mc") == 0)
+		*type = QUESTION_TYPE_MULTIPLE_CHOICE;
+	else if (g_ascii_strcasecmp (string, "true_false") == 0 ||
+	         g_ascii_strcasecmp (string, "tf") == 0)
+		*type = QUESTION_TYPE_TRUE_FALSE;
+	else
+		return FALSE;
+
+	return TRUE;
+}
+
+struct _AtsaBankReader
+{
+	AtsaBankFormat     format;
+	char              *path;
+	guint              n_skipped;
+
+	GDataInputStream  *input;
+	/* Line the stream is at, and the one the current record started on */
+	guint              line;
+	guint              record_line;
+	/* Reused for every record */
+	GString           *record;
+
+	/* CSV */
+	GPtrArray         *fields;
+	/* Fields in the header row, 0 if there is none */
+	guint              header_width;
+
+	/* JSON */
+	JsonParser        *parser;
+	char              *chunk;
+	gsize              chunk_len;
+	gsize              chunk_pos;
+
+	/* YAML */
+	AtsaQuestionBank  *bank;
+	guint              next_index;
+};
+
+static void reader_set_error (AtsaBankReader  *self,
+                              GError         **error,
+                              const char      *format,
+                              ...) G_GNUC_PRINTF (3, 4);
+
+static void
+reader_set_error (AtsaBankReader  *self,
+                  GError         **error,
+                  const char      *format,
+                  ...)
+{
+	g_autofree char *message = NULL;
+	va_list args;
+
+	va_start (args, format);
+	message = g_strdup_vprintf (format, args);
+	va_end (args);
+
+	g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+	             "%s:%u: %s", self->path, self->record_line, message);
+}
+
+/* Spreadsheets like to start CSV files with a UTF-8 byte order mark,
+ * which would otherwise end up in the first field.
+ */
+static gboolean
+reader_skip_bom (AtsaBankReader  *self,
+                 GError         **error)
+{
+	GBufferedInputStream *buffered = G_BUFFERED_INPUT_STREAM (self->input);
+	const char *data;
+	gsize available;
+
+	if (g_buffered_input_stream_fill (buffered, strlen (UTF8_BOM), NULL, error) < 0)
+		return FALSE;
+
+	data = g_buffered_input_stream_peek_buffer (buffered, &available);
+	if (available >= strlen (UTF8_BOM) && memcmp (data, UTF8_BOM, strlen (UTF8_BOM)) == 0)
+		return g_input_stream_skip (G_INPUT_STREAM (self->input), strlen (UTF8_BOM), NULL, error) >= 0;
+
+	return TRUE;
+}
+
+/* Returns the next line without its \n, but with the \r of a CRLF line
+ * end, or %NULL at the end.
+ */
+static char *
+reader_read_raw_line (AtsaBankReader  *self,
+                      gsize           *len,
+                      GError         **error)
+{
+	char *line;
+
+	line = g_data_input_stream_read_line_utf8 (self->input, len, NULL, error);
+	if (line != NULL)
+		self->line++;
+
+	return line;
+}
+
+/* Returns the next line without its terminator, or %NULL at the end */
+static char *
+reader_read_line (AtsaBankReader  *self,
+                  GError         **error)
+{
+	gsize len;
+	char *line;
+
+	line = reader_read_raw_line (self, &len, error);
+	if (line != NULL && len > 0 && line[len - 1] == '\r')
+		line[len - 1] = '\0';
+
+	return line;
+}
+
+/* Splits the next record into self->fields. Returns %FALSE at the end of
+ * the file or on error.
+ */
+static gboolean
+csv_read_record (AtsaBankReader  *self,
+                 GError         **error)
+{
+	gboolean quoted = FALSE;
+
+	g_ptr_array_set_size (self->fields, 0);
+	g_string_truncate (self->record, 0);
+	self->record_line = self->line + 1;
+
+	do
+	{
+		g_autofree char *line = NULL;
+		GError *local_error = NULL;
+		gsize len;
+
+		/* A \r is only part of the line end outside quotes */
+		line = reader_read_raw_line (self, &len, &local_error);
+		if (line == NULL)
+		{
+			if (local_error != NULL)
+				g_propagate_error (error, local_error);
+			else if (quoted)
+				reader_set_error (self, error, _("Unterminated quoted field"));
+
+			return FALSE;
+		}
+
+		/* Still inside a quoted field that spans lines */
+		if (quoted)
+			g_string_append_c (self->record, '\n');
+
+		for (const char *p = line; *p != '\0'; p++)
+		{
+			if (quoted)
+			{
+				if (*p != '"')
+					g_string_append_c (self->record, *p);
+				else if (p[1] == '"')
+				{
+					g_string_append_c (self->record, '"');
+					p++;
+				}
+				else
+					quoted = FALSE;
+			}
+			else if (*p == '"')
+			{
+				quoted = TRUE;
+			}
+			else if (*p == ',')
+			{
+				g_ptr_array_add (self->fields, g_strndup (self->record->str, self->record->len));
+				g_string_truncate (self->record, 0);
+			}
+			else
+			{
+				g_string_append_c (self->record, *p);
+			}
+		}
+
+		if (!quoted && len > 0 && line[len - 1] == '\r')
+			g_string_truncate (self->record, self->record->len - 1);
+	}
+	while (quoted);
+
+	g_ptr_array_add (self->fields, g_strndup (self->record->str, self->record->len));
+
+	return TRUE;
+}
+
+static gboolean
+csv_parse_choice (const char *answer,
+                  guint       n_choices,
+                  guint      *choice)
+{
+	guint64 number;
+
+	if (g_ascii_isalpha (answer[0]) && answer[1] == '\0')
+		*choice = g_ascii_toupper (answer[0]) - 'A';
+	else if (g_ascii_string_to_unsigned (answer, 10, 1, G_MAXUINT, &number, NULL))
+		*choice = number - 1;
+	else
+		return FALSE;
+
+	return *choice < n_choices;
+}
+
+static gboolean
+csv_parse_true_false (const char *answer,
+                      guint8     *answers,
+                      guint       n_statements)
+{
+	guint n = 0;
+
+	for (const char *p = answer; *p != '\0'; p++)
+	{
+		if (g_ascii_isspace (*p))
+			continue;
+
+		if (n == n_statements)
+			return FALSE;
+
+		switch (g_ascii_toupper (*p))
+		{
+		case 'T':
+		case '1':
+			answers[n++] = TRUE;
+			break;
+
+		case 'F':
+		case '0':
+			answers[n++] = FALSE;
+			break;
+
+		default:
+			return FALSE;
+		}
+	}
+
+	return n == n_statements;
+}
+
+static AtsaQuestion *
+csv_parse_question (AtsaBankReader  *self,
+                    GError         **error)
+{
+	char **fields = (char **) self->fields->pdata;
+	g_autoptr(AtsaQuestion) question = NULL;
+	QuestionTypeC type;
+	guint n_choices;
+
+	if (self->fields->len < 3)
+	{
+		reader_set_error (self, error, _("Expected type, question and answer"));
+		return NULL;
+	}
+
+	if (!question_type_from_string (g_strstrip (fields[0]), &type))
+	{
+		reader_set_error (self, error, _("Unknown question type “%s”"), fields[0]);
+		return NULL;
+	}
+
+	/* Spreadsheets pad rows to the widest one, which may be wider than the
+	 * header. Empty fields within the header are choices like any other.
+	 */
+	n_choices = self->fields->len - 3;
+	while (n_choices > 0 && 3 + n_choices > self->header_width &&
+	       fields[3 + n_choices - 1][0] == '\0')
+		n_choices--;
+
+	question = g_new0 (AtsaQuestion, 1);
+	question->type = type;
+	question->text = g_steal_pointer (&fields[1]);
+	question->choices = g_new0 (char *, n_choices + 1);
+	for (guint i = 0; i < n_choices; i++)
+		question->choices[i] = g_steal_pointer (&fields[3 + i]);
+
+	g_strstrip (fields[2]);
+
+	if (type == QUESTION_TYPE_MULTIPLE_CHOICE)
+	{
+		if (!csv_parse_choice (fields[2], n_choices, &question->correct_answer))
+		{
+			reader_set_error (self, error, _("“%s” is not one of the choices"), fields[2]);
+			return NULL;
+		}
+	}
+	else
+	{
+		question->tf_answers = g_new0 (guint8, MAX (n_choices, 1));
+		if (!csv_parse_true_false (fields[2], question->tf_answers, n_choices))
+		{
+			reader_set_error (self, error, _("Expected one T or F per statement, got “%s”"), fields[2]);
+			return NULL;
+		}
+	}
+
+	return g_steal_pointer (&question);
+}
+
+static AtsaQuestion *
+csv_next (AtsaBankReader  *self,
+          GError         **error)
+{
+	for (;;)
+	{
+		const char *first;
+
+		if (!csv_read_record (self, error))
+			return NULL;
+
+		first = g_ptr_array_index (self->fields, 0);
+
+		/* Blank line */
+		if (self->fields->len == 1 && first[0] == '\0')
+			continue;
+
+		if (self->record_line == 1 && g_ascii_strcasecmp (first, "type") == 0)
+		{
+			self->header_width = self->fields->len;
+			continue;
+		}
+
+		return csv_parse_question (self, error);
+	}
+}
+
+/* Copies the next top level object into self->record, skipping the array
+ * brackets and commas around it. Returns %FALSE at the end of the file or
+ * on error.
+ */
+static gboolean
+json_read_object (AtsaBankReader  *self,
+                  GError         **error)
+{
+	guint depth = 0;
+	gboolean in_string = FALSE;
+	gboolean escaped = FALSE;
+	gsize start = 0;
+
+	g_string_truncate (self->record, 0);
+
+	for (;;)
+	{
+		char c;
+
+		if (self->chunk_pos == self->chunk_len)
+		{
+			gssize n_read;
+
+			/* Keep the part of the object that is in the old chunk */
+			if (depth > 0)
+				g_string_append_len (self->record, self->chunk + start, self->chunk_len - start);
+
+			n_read = g_input_stream_read (G_INPUT_STREAM (self->input), self->chunk,
+			                              IO_BUFFER_SIZE, NULL, error);
+			if (n_read < 0)
+				return FALSE;
+
+			if (n_read == 0)
+			{
+				if (depth > 0)
+					reader_set_error (self, error, _("Unexpected end of file"));
+
+				return FALSE;
+			}
+
+			self->chunk_len = n_read;
+			self->chunk_pos = 0;
+			start = 0;
+		}
+
+		c = self->chunk[self->chunk_pos++];
+		if (c == '\n')
+			self->line++;
+
+		if (depth == 0)
+		{
+			if (c == '{')
+			{
+				depth = 1;
+				start = self->chunk_pos - 1;
+				self->record_line = self->line;
+			}
+			else if (!g_ascii_isspace (c) && c != '[' && c != ']' && c != ',')
+			{
+				self->record_line = self->line;
+				reader_set_error (self, error, _("Expected a question object"));
+				return FALSE;
+			}
+
+			continue;
+		}
+
+		if (in_string)
+		{
+			if (escaped)
+				escaped = FALSE;
+			else if (c == '\\')
+				escaped = TRUE;
+			else if (c == '"')
+				in_string = FALSE;
+		}
+		else if (c == '"')
+		{
+			in_string = TRUE;
+		}
+		else if (c == '{')
+		{
+			depth++;
+		}
+		else if (c == '}' && --depth == 0)
+		{
+			g_string_append_len (self->record, self->chunk + start, self->chunk_pos - start);
+			return TRUE;
+		}
+	}
+}
+
+static gboolean
+json_node_holds_type (JsonNode *node,
+                      GType     type)
+{
+	return JSON_NODE_HOLDS_VALUE (node) && json_node_get_value_type (node) == type;
+}
+
+static JsonArray *
+json_get_array_member (JsonObject *object,
+                       const char *name)
+{
+	JsonNode *node = json_object_get_member (object, name);
+
+	return node != NULL && JSON_NODE_HOLDS_ARRAY (node) ? json_node_get_array (node) : NULL;
+}
+
+static AtsaQuestion *
+json_next (AtsaBankReader  *self,
+           GError         **error)
+{
+	g_autoptr(AtsaQuestion) question = NULL;
+	GError *local_error = NULL;
+	JsonObject *object;
+	JsonArray *choices;
+	JsonArray *answers;
+	const char *type_name;
+	const char *text;
+	QuestionTypeC type;
+	guint n_choices;
+	gint64 answer;
+
+	if (!json_read_object (self, error))
+		return NULL;
+
+	if (!json_parser_load_from_data (self->parser, self->record->str, self->record->len, &local_error))
+	{
+		reader_set_error (self, error, "%s", local_error->message);
+		g_error_free (local_error);
+		return NULL;
+	}
+
+	object = json_node_get_object (json_parser_get_root (self->parser));
+	type_name = json_object_get_string_member_with_default (object, "type", NULL);
+	text = json_object_get_string_member_with_default (object, "question", NULL);
+	choices = json_get_array_member (object, "choices");
+
+	if (type_name == NULL || !question_type_from_string (type_name, &type))
+	{
+		reader_set_error (self, error, _("Unknown question type “%s”"), type_name != NULL ? type_name : "");
+		return NULL;
+	}
+
+	if (text == NULL || choices == NULL)
+	{
+		reader_set_error (self, error, _("Expected “question” and “choices”"));
+		return NULL;
+	}
+
+	n_choices = json_array_get_length (choices);
+
+	question = g_new0 (AtsaQuestion, 1);
+	question->type = type;
+	question->text = g_strdup (text);
+	question->choices = g_new0 (char *, n_choices + 1);
+
+	for (guint i = 0; i < n_choices; i++)
+	{
+		JsonNode *node = json_array_get_element (choices, i);
+
+		if (!json_node_holds_type (node, G_TYPE_STRING))
+		{
+			reader_set_error (self, error, _("Choices must be strings"));
+			return NULL;
+		}
+
+		question->choices[i] = json_node_dup_string (node);
+	}
+
+	if (type == QUESTION_TYPE_MULTIPLE_CHOICE)
+	{
+		JsonNode *answer_node = json_object_get_member (object, "answer");
+
+		/* Anything but an integer, such as 1.5 or "1", is an error rather
+		 * than being read as some other index.
+		 */
+		if (answer_node == NULL || !json_node_holds_type (answer_node, G_TYPE_INT64))
+		{
+			reader_set_error (self, error, _("“answer” must be the index of one of the choices"));
+			return NULL;
+		}
+
+		answer = json_node_get_int (answer_node);
+		if (answer < 0 || answer >= n_choices)
+		{
+			reader_set_error (self, error, _("“answer” must be the index of one of the choices"));
+			return NULL;
+		}
+
+		question->correct_answer = answer;
+	}
+	else
+	{
+		answers = json_get_array_member (object, "answers");
+		if (answers == NULL || json_array_get_length (answers) != n_choices)
+		{
+			reader_set_error (self, error, _("“answers” must have one entry per statement"));
+			return NULL;
+		}
+
+		question->tf_answers = g_new0 (guint8, MAX (n_choices, 1));
+		for (guint i = 0; i < n_choices; i++)
+		{
+			JsonNode *node = json_array_get_element (answers, i);
+
+			if (!json_node_holds_type (node, G_TYPE_BOOLEAN))
+			{
+				reader_set_error (self, error, _("“answers” must be true or false"));
+				return NULL;
+			}
+
+			question->tf_answers[i] = json_node_get_boolean (node);
+		}
+	}
+
+	return g_steal_pointer (&question);
+}
+
+/* Returns the first character of @chars in @p that is not escaped with a
+ * backslash, or %NULL.
+ */
+static char *
+gift_find (char       *p,
+           const char *chars)
+{
+	for (; *p != '\0'; p++)
+	{
+		if (*p == '\\' && p[1] != '\0')
+			p++;
+		else if (strchr (chars, *p) != NULL)
+			return p;
+	}
+
+	return NULL;
+}
+
+static int
+gift_count_braces (char *line)
+{
+	int depth = 0;
+
+	for (char *p = line; (p = gift_find (p, "{}")) != NULL; p++)
+		depth += *p == '{' ? 1 : -1;
+
+	return depth;
+}
+
+static char *
+gift_unescape (const char *text)
+{
+	GString *string = g_string_sized_new (strlen (text));
+
+	for (const char *p = text; *p != '\0'; p++)
+	{
+		if (*p == '\\' && p[1] != '\0')
+		{
+			p++;
+			g_string_append_c (string, *p == 'n' ? '\n' : *p);
+		}
+		else
+		{
+			g_string_append_c (string, *p);
+		}
+	}
+
+	return g_strstrip (g_string_free (string, FALSE));
+}
+
+/* Matching pairs are written as "question -> answer", an escaped "-\>"
+ * is part of the text.
+ */
+static gboolean
+gift_is_matching (char *choice)
+{
+	for (char *p = choice; (p = gift_find (p, "-")) != NULL; p++)
+	{
+		if (p[1] == '>')
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Returns the length of a text format prefix such as "[html]" at the
+ * start of @text, or 0.
+ */
+static gsize
+gift_text_format_length (const char *text)
+{
+	static const char * const text_formats[] = { "[html]", "[moodle]", "[plain]", "[markdown]" };
+
+	for (guint i = 0; i < G_N_ELEMENTS (text_formats); i++)
+	{
+		if (g_str_has_prefix (text, text_formats[i]))
+			return strlen (text_formats[i]);
+	}
+
+	return 0;
+}
+
+/* Puts a blank in place of the answers for questions like
+ * "Mahatma Gandhi's birthday is an Indian holiday on {~15th =2nd} October."
+ */
+static char *
+gift_join (char       *text,
+           const char *tail)
+{
+	char *joined;
+
+	if (*tail == '\0')
+		return text;
+
+	joined = g_strconcat (text, " _____ ", tail, NULL);
+	g_free (text);
+
+	return joined;
+}
+
+/* Collects the lines of the next question into self->record, leaving out
+ * comments and category lines. Questions are separated by blank lines.
+ */
+static gboolean
+gift_read_block (AtsaBankReader  *self,
+                 GError         **error)
+{
+	int depth = 0;
+
+	g_string_truncate (self->record, 0);
+
+	for (;;)
+	{
+		g_autofree char *line = NULL;
+		GError *local_error = NULL;
+		const char *stripped;
+
+		line = reader_read_line (self, &local_error);
+		if (line == NULL)
+		{
+			if (local_error != NULL)
+			{
+				g_propagate_error (error, local_error);
+				return FALSE;
+			}
+
+			return self->record->len > 0;
+		}
+
+		stripped = line;
+		while (g_ascii_isspace (*stripped))
+			stripped++;
+
+		if (depth <= 0)
+		{
+			if (*stripped == '\0')
+			{
+				if (self->record->len > 0)
+					return TRUE;
+
+				continue;
+			}
+
+			if (g_str_has_prefix (stripped, "//") ||
+			    (self->record->len == 0 && g_str_has_prefix (stripped, "$CATEGORY:")))
+				continue;
+		}
+
+		if (self->record->len == 0)
+			self->record_line = self->line;
+		else
+			g_string_append_c (self->record, '\n');
+
+		g_string_append (self->record, line);
+		depth += gift_count_braces (line);
+	}
+}
+
+static gboolean
+gift_parse_true_false (char     *answers,
+                       gboolean *answer)
+{
+	char *feedback = gift_find (answers, "#");
+	g_autofree char *word = NULL;
+
+	word = g_strstrip (feedback != NULL ? g_strndup (answers, feedback - answers) : g_strdup (answers));
+
+	if (g_ascii_strcasecmp (word, "T") == 0 || g_ascii_strcasecmp (word, "TRUE") == 0)
+		*answer = TRUE;
+	else if (g_ascii_strcasecmp (word, "F") == 0 || g_ascii_strcasecmp (word, "FALSE") == 0)
+		*answer = FALSE;
+	else
+		return FALSE;
+
+	return TRUE;
+}
+
+/* Returns %FALSE for answers that don't make a multiple choice question:
+ * short answer, matching and multiple answer questions.
+ */
+static gboolean
+gift_parse_choices (char      *answers,
+                    GPtrArray *choices,
+                    guint     *correct)
+{
+	gboolean has_correct = FALSE;
+
+	for (char *p = gift_find (answers, "=~"); p != NULL;)
+	{
+		gboolean is_correct = *p == '=';
+		char *choice = p + 1;
+		char *next = gift_find (choice, "=~");
+		char *feedback;
+		char saved = '\0';
+
+		if (next != NULL)
+		{
+			saved = *next;
+			*next = '\0';
+		}
+
+		if (gift_is_matching (choice) || (is_correct && has_correct))
+			return FALSE;
+
+		/* Partial credit, as in ~%50% */
+		if (*choice == '%' && strchr (choice + 1, '%') != NULL)
+			choice = strchr (choice + 1, '%') + 1;
+
+		feedback = gift_find (choice, "#");
+		if (feedback != NULL)
+			*feedback = '\0';
+
+		if (is_correct)
+		{
+			has_correct = TRUE;
+			*correct = choices->len;
+		}
+
+		g_ptr_array_add (choices, gift_unescape (choice));
+
+		if (next != NULL)
+			*next = saved;
+		p = next;
+	}
+
+	return has_correct && choices->len > 1;
+}
+
+/* Parses self->record. Sets @question to %NULL for questions that have no
+ * equivalent in a bank.
+ */
+static gboolean
+gift_parse_question (AtsaBankReader  *self,
+                     AtsaQuestion   **question,
+                     GError         **error)
+{
+	char *text = self->record->str;
+	g_autofree char *tail = NULL;
+	char *open;
+	char *close;
+	char *answers;
+	gboolean answer;
+
+	*question = NULL;
+
+	while (g_ascii_isspace (*text))
+		text++;
+
+	/* Question title, ::title:: */
+	if (g_str_has_prefix (text, "::"))
+	{
+		char *p = text + 2;
+
+		while ((p = gift_find (p, ":")) != NULL && p[1] != ':')
+			p++;
+
+		if (p == NULL)
+		{
+			reader_set_error (self, error, _("Unterminated question title"));
+			return FALSE;
+		}
+
+		text = p + 2;
+	}
+
+	while (g_ascii_isspace (*text))
+		text++;
+
+	/* Text format such as [html], the text is kept as it is. Anything else
+	 * in brackets is part of the question.
+	 */
+	text += gift_text_format_length (text);
+
+	open = gift_find (text, "{");
+	if (open == NULL)
+		return TRUE;
+
+	close = gift_find (open + 1, "}");
+	if (close == NULL)
+	{
+		reader_set_error (self, error, _("Missing “}”"));
+		return FALSE;
+	}
+
+	*open = '\0';
+	*close = '\0';
+	tail = gift_unescape (close + 1);
+
+	answers = open + 1;
+	while (g_ascii_isspace (*answers))
+		answers++;
+
+	/* Essay and numerical questions */
+	if (*answers == '\0' || *answers == '#')
+		return TRUE;
+
+	if (gift_parse_true_false (answers, &answer))
+	{
+		char *statement = strrchr (text, '\n');
+
+		*question = g_new0 (AtsaQuestion, 1);
+		(*question)->type = QUESTION_TYPE_TRUE_FALSE;
+
+		if (statement != NULL)
+		{
+			*statement++ = '\0';
+			(*question)->text = gift_unescape (text);
+		}
+		else
+		{
+			statement = text;
+			(*question)->text = g_strdup ("");
+		}
+
+		(*question)->choices = g_new0 (char *, 2);
+		(*question)->choices[0] = gift_join (gift_unescape (statement), tail);
+		(*question)->tf_answers = g_new0 (guint8, 1);
+		(*question)->tf_answers[0] = answer;
+	}
+	else
+	{
+		g_autoptr(GPtrArray) choices = g_ptr_array_new_with_free_func (g_free);
+		guint correct = 0;
+
+		if (!gift_parse_choices (answers, choices, &correct))
+			return TRUE;
+
+		g_ptr_array_add (choices, NULL);
+
+		*question = g_new0 (AtsaQuestion, 1);
+		(*question)->type = QUESTION_TYPE_MULTIPLE_CHOICE;
+		(*question)->text = gift_join (gift_unescape (text), tail);
+		(*question)->choices = (GStrv) g_ptr_array_steal (choices, NULL);
+		(*question)->correct_answer = correct;
+	}
+
+	return TRUE;
+}
+
+static AtsaQuestion *
+gift_next (AtsaBankReader  *self,
+           GError         **error)
+{
+	AtsaQuestion *question = NULL;
+
+	while (question == NULL)
+	{
+		if (!gift_read_block (self, error) ||
+		    !gift_parse_question (self, &question, error))
+			return NULL;
+
+		if (question == NULL)
+			self->n_skipped++;
+	}
+
+	return question;
+}
+
+/**
+ * atsa_bank_reader_new:
+ * @path: path of a question file
+ * @error: return location for a #GError
+ *
+ * Opens @path for reading in the format given by its extension.
+ *
+ * Returns: (transfer full): the reader, or %NULL on error
+ */
+AtsaBankReader *
+atsa_bank_reader_new (const char  *path,
+                      GError     **error)
+{
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GFileInputStream) stream = NULL;
+	AtsaBankReader *self;
+	AtsaBankFormat format;
+
+	g_return_val_if_fail (path != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	format = atsa_bank_format_from_path (path);
+	if (format == ATSA_BANK_FORMAT_UNKNOWN)
+	{
+		g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+		             _("“%s” is not a known question file format"), path);
+		return NULL;
+	}
+
+	self = g_new0 (AtsaBankReader, 1);
+	self->format = format;
+	self->path = g_strdup (path);
+	self->record = g_string_new (NULL);
+
+	if (format == ATSA_BANK_FORMAT_YAML)
+	{
+		self->bank = atsa_question_bank_load (path, error);
+		if (self->bank == NULL)
+		{
+			atsa_bank_reader_free (self);
+			return NULL;
+		}
+
+		return self;
+	}
+
+	file = g_file_new_for_path (path);
+	stream = g_file_read (file, NULL, error);
+	if (stream == NULL)
+	{
+		atsa_bank_reader_free (self);
+		return NULL;
+	}
+
+	self->input = g_data_input_stream_new (G_INPUT_STREAM (stream));
+	g_buffered_input_stream_set_buffer_size (G_BUFFERED_INPUT_STREAM (self->input), IO_BUFFER_SIZE);
+
+	if (!reader_skip_bom (self, error))
+	{
+		atsa_bank_reader_free (self);
+		return NULL;
+	}
+
+	if (format == ATSA_BANK_FORMAT_CSV)
+	{
+		self->fields = g_ptr_array_new_with_free_func (g_free);
+	}
+	else if (format == ATSA_BANK_FORMAT_JSON)
+	{
+		self->parser = json_parser_new_immutable ();
+		self->chunk = g_malloc (IO_BUFFER_SIZE);
+		self->line = 1;
+	}
+
+	return self;
+}
+
+/**
+ * atsa_bank_reader_next:
+ * @self: a #AtsaBankReader
+ * @error: return location for a #GError
+ *
+ * Reads the next question. Questions the format has but a bank can't hold
+ * are skipped, see atsa_bank_reader_get_n_skipped().
+ *
+ * Returns: (transfer full) (nullable): the question, or %NULL at the end
+ *   of the file or on error
+ */
+AtsaQuestion *
+atsa_bank_reader_next (AtsaBankReader  *self,
+                       GError         **error)
+{
+	g_return_val_if_fail (self != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	switch (self->format)
+	{
+	case ATSA_BANK_FORMAT_CSV:
+		return csv_next (self, error);
+
+	case ATSA_BANK_FORMAT_JSON:
+		return json_next (self, error);
+
+	case ATSA_BANK_FORMAT_GIFT:
+		return gift_next (self, error);
+
+	case ATSA_BANK_FORMAT_YAML:
+		if (self->next_index == atsa_question_bank_get_n_questions (self->bank))
+			return NULL;
+
+		return atsa_question_copy (atsa_question_bank_get_question (self->bank, self->next_index++));
+
+	case ATSA_BANK_FORMAT_UNKNOWN:
+	default:
+		break;
+	}
+
+	g_return_val_if_reached (NULL);
+}
+
+guint
+atsa_bank_reader_get_n_skipped (AtsaBankReader *self)
+{
+	g_return_val_if_fail (self != NULL, 0);
+
+	return self->n_skipped;
+}
+
+void
+atsa_bank_reader_free (AtsaBankReader *self)
+{
+	if (self == NULL)
+		return;
+
+	g_free (self->path);
+	g_clear_object (&self->input);
+	g_string_free (self->record, TRUE);
+	g_clear_pointer (&self->fields, g_ptr_array_unref);
+	g_clear_object (&self->parser);
+	g_free (self->chunk);
+	g_clear_pointer (&self->bank, atsa_question_bank_unref);
+	g_free (self);
+}
+
+struct _AtsaBankWriter
+{
+	AtsaBankFormat  format;
+	GFile          *file;
+	/* Written to and moved over @file once complete */
+	GFile          *tmp_file;
+	GOutputStream  *output;
+	guint           n_written;
+	gboolean        closed;
+	/* Reused for every record */
+	GString        *record;
+
+	/* JSON */
+	JsonBuilder    *builder;
+	JsonGenerator  *generator;
+};
+
+static void
+csv_append_field (GString    *out,
+                  const char *field)
+{
+	if (strpbrk (field, ",\"\r\n") == NULL)
+	{
+		g_string_append (out, field);
+		return;
+	}
+
+	g_string_append_c (out, '"');
+	for (const char *p = field; *p != '\0'; p++)
+	{
+		if (*p == '"')
+			g_string_append_c (out, '"');
+		g_string_append_c (out, *p);
+	}
+	g_string_append_c (out, '"');
+}
+
+static void
+csv_format_question (GString            *out,
+                     const AtsaQuestion *question)
+{
+	g_string_append (out, question_type_to_string (question->type));
+	g_string_append_c (out, ',');
+	csv_append_field (out, question->text);
+	g_string_append_c (out, ',');
+
+	if (question->type == QUESTION_TYPE_MULTIPLE_CHOICE)
+	{
+		if (question->correct_answer < 26)
+			g_string_append_c (out, 'A' + question->correct_answer);
+		else
+			g_string_append_printf (out, "%u", question->correct_answer + 1);
+	}
+	else
+	{
+		for (guint i = 0; question->choices[i] != NULL; i++)
+			g_string_append_c (out, question->tf_answers[i] ? 'T' : 'F');
+	}
+
+	for (guint i = 0; question->choices[i] != NULL; i++)
+	{
+		g_string_append_c (out, ',');
+		csv_append_field (out, question->choices[i]);
+	}
+
+	g_string_append_c (out, '\n');
+}
+
+static void
+json_format_question (AtsaBankWriter     *self,
+                      const AtsaQuestion *question)
+{
+	JsonNode *root;
+
+	json_builder_reset (self->builder);
+	json_builder_begin_object (self->builder);
+
+	json_builder_set_member_name (self->builder, "type");
+	json_builder_add_string_value (self->builder, question_type_to_string (question->type));
+	json_builder_set_member_name (self->builder, "question");
+	json_builder_add_string_value (self->builder, question->text);
+
+	json_builder_set_member_name (self->builder, "choices");
+	json_builder_begin_array (self->builder);
+	for (guint i = 0; question->choices[i] != NULL; i++)
+		json_builder_add_string_value (self->builder, question->choices[i]);
+	json_builder_end_array (self->builder);
+
+	if (question->type == QUESTION_TYPE_MULTIPLE_CHOICE)
+	{
+		json_builder_set_member_name (self->builder, "answer");
+		json_builder_add_int_value (self->builder, question->correct_answer);
+	}
+	else
+	{
+		json_builder_set_member_name (self->builder, "answers");
+		json_builder_begin_array (self->builder);
+		for (guint i = 0; question->choices[i] != NULL; i++)
+			json_builder_add_boolean_value (self->builder, question->tf_answers[i]);
+		json_builder_end_array (self->builder);
+	}
+
+	json_builder_end_object (self->builder);
+
+	/* One question per line keeps the file readable line by line too */
+	g_string_append (self->record, self->n_written == 0 ? "[\n" : ",\n");
+
+	root = json_builder_get_root (self->builder);
+	json_generator_set_root (self->generator, root);
+	json_generator_to_gstring (self->generator, self->record);
+	json_node_unref (root);
+}
+
+/* Besides the special characters this escapes the ">" of "->", which
+ * would make a choice a matching pair, and what the reader looks for at
+ * the start of a field: "[" of a text format, "%" of partial credit and
+ * "/" of a comment line.
+ */
+static void
+gift_append_escaped (GString    *out,
+                     const char *text)
+{
+	gboolean leading = TRUE;
+
+	for (const char *p = text; *p != '\0'; p++)
+	{
+		switch (*p)
+		{
+		case '[':
+		case '%':
+		case '/':
+			if (leading)
+				g_string_append_c (out, '\\');
+			g_string_append_c (out, *p);
+			break;
+
+		case '>':
+			if (p > text && p[-1] == '-')
+				g_string_append_c (out, '\\');
+			g_string_append_c (out, *p);
+			break;
+
+		case '~':
+		case '=':
+		case '#':
+		case '{':
+		case '}':
+		case ':':
+		case '\\':
+			g_string_append_c (out, '\\');
+			g_string_append_c (out, *p);
+			break;
+
+		case '\n':
+			g_string_append (out, "\\n");
+			break;
+
+		default:
+			g_string_append_c (out, *p);
+			break;
+		}
+
+		if (!g_ascii_isspace (*p))
+			leading = FALSE;
+	}
+}
+
+static void
+gift_format_question (GString            *out,
+                      const AtsaQuestion *question,
+                      guint               number)
+{
+	if (question->type == QUESTION_TYPE_MULTIPLE_CHOICE)
+	{
+		g_string_append_printf (out, "::Q%u:: ", number);
+		gift_append_escaped (out, question->text);
+		g_string_append (out, " {\n");
+
+		for (guint i = 0; question->choices[i] != NULL; i++)
+		{
+			g_string_append (out, i == question->correct_answer ? "\t=" : "\t~");
+			gift_append_escaped (out, question->choices[i]);
+			g_string_append_c (out, '\n');
+		}
+
+		g_string_append (out, "}\n\n");
+		return;
+	}
+
+	for (guint i = 0; question->choices[i] != NULL; i++)
+	{
+		g_string_append_printf (out, "::Q%u.%u:: ", number, i + 1);
+		if (question->text[0] != '\0')
+		{
+			gift_append_escaped (out, question->text);
+			g_string_append_c (out, '\n');
+		}
+		gift_append_escaped (out, question->choices[i]);
+		g_string_append (out, question->tf_answers[i] ? " {T}\n\n" : " {F}\n\n");
+	}
+}
+
+/* Creates a new, uniquely named file next to @file */
+static GFileOutputStream *
+create_tmp_file (GFile   *file,
+                 GFile  **tmp_file,
+                 GError **error)
+{
+	g_autoptr(GFile) parent = g_file_get_parent (file);
+	g_autofree char *basename = g_file_get_basename (file);
+
+	for (guint i = 0; ; i++)
+	{
+		g_autofree char *name = g_strdup_printf (".%s.%08x", basename, g_random_int ());
+		g_autoptr(GError) local_error = NULL;
+		GFileOutputStream *stream;
+
+		*tmp_file = g_file_get_child (parent, name);
+		stream = g_file_create (*tmp_file, G_FILE_CREATE_NONE, NULL, &local_error);
+		if (stream != NULL)
+			return stream;
+
+		g_clear_object (tmp_file);
+		if (!g_error_matches (local_error, G_IO_ERROR, G_IO_ERROR_EXISTS) || i + 1 == MAX_TMP_ATTEMPTS)
+		{
+			g_propagate_error (error, g_steal_pointer (&local_error));
+			return NULL;
+		}
+	}
+}
+
+/**
+ * atsa_bank_writer_new:
+ * @path: path of the file to write, replaced once the writer is closed
+ * @format: %ATSA_BANK_FORMAT_CSV, %ATSA_BANK_FORMAT_JSON or
+ *   %ATSA_BANK_FORMAT_GIFT
+ * @error: return location for a #GError
+ *
+ * Returns: (transfer full): the writer, or %NULL on error
+ */
+AtsaBankWriter *
+atsa_bank_writer_new (const char      *path,
+                      AtsaBankFormat   format,
+                      GError         **error)
+{
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GFile) tmp_file = NULL;
+	g_autoptr(GFileOutputStream) stream = NULL;
+	AtsaBankWriter *self;
+
+	g_return_val_if_fail (path != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	if (!format_is_writable (format))
+	{
+		g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+		             _("Questions can only be written as CSV, JSON or GIFT"));
+		return NULL;
+	}
+
+	file = g_file_new_for_path (path);
+	stream = create_tmp_file (file, &tmp_file, error);
+	if (stream == NULL)
+		return NULL;
+
+	self = g_new0 (AtsaBankWriter, 1);
+	self->format = format;
+	self->file = g_steal_pointer (&file);
+	self->tmp_file = g_steal_pointer (&tmp_file);
+	self->output = g_buffered_output_stream_new_sized (G_OUTPUT_STREAM (stream), IO_BUFFER_SIZE);
+	self->record = g_string_new (NULL);
+
+	if (format == ATSA_BANK_FORMAT_JSON)
+	{
+		self->builder = json_builder_new_immutable ();
+		self->generator = json_generator_new ();
+	}
+	else if (format == ATSA_BANK_FORMAT_CSV &&
+	         !g_output_stream_write_all (self->output, "type,question,answer,choices\n",
+	                                     strlen ("type,question,answer,choices\n"), NULL, NULL, error))
+	{
+		atsa_bank_writer_free (self);
+		return NULL;
+	}
+
+	return self;
+}
+
+/**
+ * atsa_bank_writer_write:
+ * @self: a #AtsaBankWriter
+ * @question: a multiple choice or true/false question
+ * @error: return location for a #GError
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+atsa_bank_writer_write (AtsaBankWriter      *self,
+                        const AtsaQuestion  *question,
+                        GError             **error)
+{
+	g_return_val_if_fail (self != NULL, FALSE);
+	g_return_val_if_fail (question != NULL, FALSE);
+	g_return_val_if_fail (question->type == QUESTION_TYPE_MULTIPLE_CHOICE ||
+	                      question->type == QUESTION_TYPE_TRUE_FALSE, FALSE);
+
+	g_string_truncate (self->record, 0);
+
+	switch (self->format)
+	{
+	case ATSA_BANK_FORMAT_CSV:
+		csv_format_question (self->record, question);
+		break;
+
+	case ATSA_BANK_FORMAT_JSON:
+		json_format_question (self, question);
+		break;
+
+	case ATSA_BANK_FORMAT_GIFT:
+		gift_format_question (self->record, question, self->n_written + 1);
+		break;
+
+	case ATSA_BANK_FORMAT_YAML:
+	case ATSA_BANK_FORMAT_UNKNOWN:
+	default:
+		g_return_val_if_reached (FALSE);
+	}
+
+	self->n_written++;
+
+	return g_output_stream_write_all (self->output, self->record->str, self->record->len,
+	                                  NULL, NULL, error);
+}
+
+/**
+ * atsa_bank_writer_close:
+ * @self: a #AtsaBankWriter
+ * @error: return location for a #GError
+ *
+ * Finishes the file and moves it into place. Until this returns %TRUE
+ * nothing has been written to the path the writer was created for.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+atsa_bank_writer_close (AtsaBankWriter  *self,
+                        GError         **error)
+{
+	const char *footer = NULL;
+
+	g_return_val_if_fail (self != NULL, FALSE);
+
+	if (self->format == ATSA_BANK_FORMAT_JSON)
+		footer = self->n_written > 0 ? "\n]\n" : "[]\n";
+
+	if (footer != NULL &&
+	    !g_output_stream_write_all (self->output, footer, strlen (footer), NULL, NULL, error))
+		return FALSE;
+
+	self->closed = g_output_stream_close (self->output, NULL, error) &&
+	               g_file_move (self->tmp_file, self->file, G_FILE_COPY_OVERWRITE,
+	                            NULL, NULL, NULL, error);
+
+	return self->closed;
+}
+
+/**
+ * atsa_bank_writer_free:
+ * @self: a #AtsaBankWriter
+ *
+ * Frees @self. If atsa_bank_writer_close() hasn't succeeded the
+ * temporary file the questions went to is deleted, and a file that
+ * existed at the path before is left as it was.
+ */
+void
+atsa_bank_writer_free (AtsaBankWriter *self)
+{
+	if (self == NULL)
+		return;
+
+	if (!self->closed)
+	{
+		g_output_stream_close (self->output, NULL, NULL);
+		g_file_delete (self->tmp_file, NULL, NULL);
+	}
+
+	g_clear_object (&self->output);
+	g_clear_object (&self->file);
+	g_clear_object (&self->tmp_file);
+	g_string_free (self->record, TRUE);
+	g_clear_object (&self->builder);
+	g_clear_object (&self->generator);
+	g_free (self);
+}
+
+typedef struct
+{
+	const char * const *inputs;
+	const char         *directory;
+	AtsaBankFormat      format;
+} ConvertData;
+
+static char *
+output_path (const char     *directory,
+             const char     *input,
+             AtsaBankFormat  format)
+{
+	g_autofree char *basename = g_path_get_basename (input);
+	g_autofree char *name = NULL;
+	char *dot = strrchr (basename, '.');
+
+	if (dot != NULL && dot != basename)
+		*dot = '\0';
+
+	name = g_strconcat (basename, ".", atsa_bank_format_get_extension (format), NULL);
+
+	return g_build_filename (directory, name, NULL);
+}
+
+static gboolean
+convert_file_func (guint          index,
+                   gpointer       user_data,
+                   GCancellable  *cancellable,
+                   GError       **error)
+{
+	ConvertData *data = user_data;
+	const char *input = data->inputs[index];
+	g_autoptr(AtsaBankReader) reader = NULL;
+	g_autoptr(AtsaBankWriter) writer = NULL;
+	g_autofree char *output = NULL;
+	GError *local_error = NULL;
+
+	output = output_path (data->directory, input, data->format);
+
+	reader = atsa_bank_reader_new (input, error);
+	if (reader == NULL)
+		return FALSE;
+
+	writer = atsa_bank_writer_new (output, data->format, error);
+	if (writer == NULL)
+		return FALSE;
+
+	while (!g_cancellable_set_error_if_cancelled (cancellable, &local_error))
+	{
+		g_autoptr(AtsaQuestion) question = atsa_bank_reader_next (reader, &local_error);
+
+		if (question == NULL)
+			break;
+
+		/* Only the Rust library produces these */
+		if (question->type == QUESTION_TYPE_NONE)
+			continue;
+
+		if (!atsa_bank_writer_write (writer, question, &local_error))
+			break;
+	}
+
+	if (local_error == NULL && atsa_bank_writer_close (writer, &local_error))
+	{
+		if (atsa_bank_reader_get_n_skipped (reader) > 0)
+			g_message (_("Skipped %u questions of unsupported types in “%s”"),
+			           atsa_bank_reader_get_n_skipped (reader), input);
+
+		return TRUE;
+	}
+
+	/* Freeing the writer without closing it leaves no half written file */
+	g_propagate_error (error, local_error);
+
+	return FALSE;
+}
+
+/* Two inputs that only differ in their directory or extension would write
+ * the same output file from two threads.
+ */
+static gboolean
+check_outputs (const char * const  *inputs,
+               const char          *directory,
+               AtsaBankFormat       format,
+               GError             **error)
+{
+	g_autoptr(GHashTable) outputs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	for (guint i = 0; inputs[i] != NULL; i++)
+	{
+		g_autoptr(GFile) input = g_file_new_for_path (inputs[i]);
+		g_autoptr(GFile) output = NULL;
+		char *path = output_path (directory, inputs[i], format);
+
+		output = g_file_new_for_path (path);
+		if (g_file_equal (input, output))
+		{
+			g_set_error (error, G_IO_ERROR, G_IO_ERROR_EXISTS,
+			             _("Converting “%s” would overwrite it"), inputs[i]);
+			g_free (path);
+			return FALSE;
+		}
+
+		if (!g_hash_table_add (outputs, path))
+		{
+			g_set_error (error, G_IO_ERROR, G_IO_ERROR_EXISTS,
+			             _("More than one file would be converted to “%s”"), path);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * atsa_bank_convert_files:
+ * @inputs: (array zero-terminated=1): question files to convert
+ * @directory: directory to write the converted files to
+ * @format: format to convert to
+ * @cancellable: (nullable): a #GCancellable
+ * @error: return location for a #GError
+ *
+ * Converts every file in @inputs to @format, writing NAME.EXT into
+ * @directory. Files are converted in parallel, one worker per core, each
+ * streaming one question at a time. Blocks until all files are done; on
+ * error no partially written file is left behind.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+atsa_bank_convert_files (const char * const  *inputs,
+                         const char          *directory,
+                         AtsaBankFormat       format,
+                         GCancellable        *cancellable,
+                         GError             **error)
+{
+	ConvertData data = { 0 };
+
+	g_return_val_if_fail (inputs != NULL, FALSE);
+	g_return_val_if_fail (directory != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (!format_is_writable (format))
+	{
+		g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+		             _("Questions can only be written as CSV, JSON or GIFT"));
+		return FALSE;
+	}
+
+	if (!check_outputs (inputs, directory, format, error))
+		return FALSE;
+
+	if (g_mkdir_with_parents (directory, 0755) != 0)
+	{
+		int errsv = errno;
+
+		g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+		             _("Failed to create “%s”: %s"), directory, g_strerror (errsv));
+		return FALSE;
+	}
+
+	data.inputs = inputs;
+	data.directory = directory;
+	data.format = format;
+
+	return atsa_worker_pool_run (g_strv_length ((GStrv) inputs), convert_file_func, &data,
+	                             cancellable, error);
+}
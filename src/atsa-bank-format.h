@@ -0,0 +1,72 @@
+/* atsa-bank-format.h
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "atsa-question-bank.h"
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+	ATSA_BANK_FORMAT_UNKNOWN,
+	ATSA_BANK_FORMAT_YAML,
+	ATSA_BANK_FORMAT_CSV,
+	ATSA_BANK_FORMAT_JSON,
+	ATSA_BANK_FORMAT_GIFT,
+} AtsaBankFormat;
+
+AtsaBankFormat  atsa_bank_format_from_path     (const char          *path);
+AtsaBankFormat  atsa_bank_format_from_name     (const char          *name);
+const char     *atsa_bank_format_get_extension (AtsaBankFormat       format);
+
+typedef struct _AtsaBankReader AtsaBankReader;
+
+AtsaBankReader *atsa_bank_reader_new           (const char          *path,
+                                                GError             **error);
+AtsaQuestion   *atsa_bank_reader_next          (AtsaBankReader      *self,
+                                                GError             **error);
+guint           atsa_bank_reader_get_n_skipped (AtsaBankReader      *self);
+void            atsa_bank_reader_free          (AtsaBankReader      *self);
+
+typedef struct _AtsaBankWriter AtsaBankWriter;
+
+AtsaBankWriter *atsa_bank_writer_new           (const char          *path,
+                                                AtsaBankFormat       format,
+                                                GError             **error);
+gboolean        atsa_bank_writer_write         (AtsaBankWriter      *self,
+                                                const AtsaQuestion  *question,
+                                                GError             **error);
+gboolean        atsa_bank_writer_close         (AtsaBankWriter      *self,
+                                                GError             **error);
+void            atsa_bank_writer_free          (AtsaBankWriter      *self);
+
+gboolean        atsa_bank_convert_files        (const char * const  *inputs,
+                                                const char          *directory,
+                                                AtsaBankFormat       format,
+                                                GCancellable        *cancellable,
+                                                GError             **error);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (AtsaBankReader, atsa_bank_reader_free)
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (AtsaBankWriter, atsa_bank_writer_free)
+
+G_END_DECLS
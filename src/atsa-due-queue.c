@@ -0,0 +1,257 @@
+/* atsa-due-queue.c
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include "atsa-due-queue.h"
+
+/* An indexed binary min-heap of questions ordered by due time.
+ *
+ * Next to the heap a hash table maps each question hash to its node, and
+ * every node knows its position in the heap, so changing the due time of
+ * or removing any question is O(log n) instead of a linear search.
+ */
+
+typedef struct
+{
+	guint64 hash;
+	gint64  due;
+	guint   pos;
+} Node;
+
+struct _AtsaDueQueue
+{
+	GPtrArray  *heap;
+	/* &node->hash → node, owns the nodes */
+	GHashTable *nodes;
+};
+
+static inline gboolean
+node_before (const Node *a,
+             const Node *b)
+{
+	/* Ties are broken by hash so the order doesn't depend on insertion */
+	return a->due < b->due || (a->due == b->due && a->hash < b->hash);
+}
+
+static inline void
+heap_place (AtsaDueQueue *self,
+            Node         *node,
+            guint         pos)
+{
+	g_ptr_array_index (self->heap, pos) = node;
+	node->pos = pos;
+}
+
+static void
+sift_up (AtsaDueQueue *self,
+         Node         *node)
+{
+	guint pos = node->pos;
+
+	while (pos > 0)
+	{
+		guint parent_pos = (pos - 1) / 2;
+		Node *parent = g_ptr_array_index (self->heap, parent_pos);
+
+		if (!node_before (node, parent))
+			break;
+
+		heap_place (self, parent, pos);
+		pos = parent_pos;
+	}
+
+	heap_place (self, node, pos);
+}
+
+static void
+sift_down (AtsaDueQueue *self,
+           Node         *node)
+{
+	guint len = self->heap->len;
+	guint pos = node->pos;
+
+	for (;;)
+	{
+		guint child_pos = 2 * pos + 1;
+		Node *child;
+
+		if (child_pos >= len)
+			break;
+
+		if (child_pos + 1 < len &&
+		    node_before (g_ptr_array_index (self->heap, child_pos + 1),
+		                 g_ptr_array_index (self->heap, child_pos)))
+			child_pos++;
+
+		child = g_ptr_array_index (self->heap, child_pos);
+		if (!node_before (child, node))
+			break;
+
+		heap_place (self, child, pos);
+		pos = child_pos;
+	}
+
+	heap_place (self, node, pos);
+}
+
+AtsaDueQueue *
+atsa_due_queue_new (void)
+{
+	AtsaDueQueue *self = g_new0 (AtsaDueQueue, 1);
+
+	self->heap = g_ptr_array_new ();
+	self->nodes = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL, g_free);
+
+	return self;
+}
+
+void
+atsa_due_queue_free (AtsaDueQueue *self)
+{
+	if (self == NULL)
+		return;
+
+	g_ptr_array_unref (self->heap);
+	g_hash_table_unref (self->nodes);
+	g_free (self);
+}
+
+guint
+atsa_due_queue_get_size (AtsaDueQueue *self)
+{
+	g_return_val_if_fail (self != NULL, 0);
+
+	return self->heap->len;
+}
+
+/**
+ * atsa_due_queue_set:
+ * @self: a #AtsaDueQueue
+ * @hash: the question
+ * @due: when it is due
+ *
+ * Adds @hash to the queue, or moves it if it is already queued.
+ */
+void
+atsa_due_queue_set (AtsaDueQueue *self,
+                    guint64       hash,
+                    gint64        due)
+{
+	Node *node;
+
+	g_return_if_fail (self != NULL);
+
+	node = g_hash_table_lookup (self->nodes, &hash);
+
+	if (node == NULL)
+	{
+		node = g_new (Node, 1);
+		node->hash = hash;
+		node->due = due;
+		node->pos = self->heap->len;
+		g_ptr_array_add (self->heap, node);
+		g_hash_table_insert (self->nodes, &node->hash, node);
+		sift_up (self, node);
+	}
+	else if (due < node->due)
+	{
+		node->due = due;
+		sift_up (self, node);
+	}
+	else
+	{
+		node->due = due;
+		sift_down (self, node);
+	}
+}
+
+/**
+ * atsa_due_queue_remove:
+ * @self: a #AtsaDueQueue
+ * @hash: the question
+ *
+ * Returns: %TRUE if @hash was queued
+ */
+gboolean
+atsa_due_queue_remove (AtsaDueQueue *self,
+                       guint64       hash)
+{
+	Node *node;
+	Node *last;
+
+	g_return_val_if_fail (self != NULL, FALSE);
+
+	node = g_hash_table_lookup (self->nodes, &hash);
+	if (node == NULL)
+		return FALSE;
+
+	last = g_ptr_array_steal_index (self->heap, self->heap->len - 1);
+	if (last != node)
+	{
+		/* Move the last node into the hole and restore the heap property */
+		heap_place (self, last, node->pos);
+		if (node_before (last, node))
+			sift_up (self, last);
+		else
+			sift_down (self, last);
+	}
+
+	g_hash_table_remove (self->nodes, &hash);
+
+	return TRUE;
+}
+
+/**
+ * atsa_due_queue_peek:
+ * @self: a #AtsaDueQueue
+ * @hash: (out): return location for the question due first
+ * @due: (out) (optional): return location for when it is due
+ *
+ * Returns: %FALSE if the queue is empty
+ */
+gboolean
+atsa_due_queue_peek (AtsaDueQueue *self,
+                     guint64      *hash,
+                     gint64       *due)
+{
+	Node *first;
+
+	g_return_val_if_fail (self != NULL, FALSE);
+
+	if (self->heap->len == 0)
+		return FALSE;
+
+	first = g_ptr_array_index (self->heap, 0);
+	*hash = first->hash;
+	if (due != NULL)
+		*due = first->due;
+
+	return TRUE;
+}
+
+void
+atsa_due_queue_clear (AtsaDueQueue *self)
+{
+	g_return_if_fail (self != NULL);
+
+	g_ptr_array_set_size (self->heap, 0);
+	g_hash_table_remove_all (self->nodes);
+}
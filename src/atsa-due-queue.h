@@ -0,0 +1,44 @@
+/* atsa-due-queue.h
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _AtsaDueQueue AtsaDueQueue;
+
+AtsaDueQueue *atsa_due_queue_new      (void);
+void          atsa_due_queue_free     (AtsaDueQueue *self);
+guint         atsa_due_queue_get_size (AtsaDueQueue *self);
+void          atsa_due_queue_set      (AtsaDueQueue *self,
+                                       guint64       hash,
+                                       gint64        due);
+gboolean      atsa_due_queue_remove   (AtsaDueQueue *self,
+                                       guint64       hash);
+gboolean      atsa_due_queue_peek     (AtsaDueQueue *self,
+                                       guint64      *hash,
+                                       gint64       *due);
+void          atsa_due_queue_clear    (AtsaDueQueue *self);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (AtsaDueQueue, atsa_due_queue_free)
+
+G_END_DECLS
@@ -0,0 +1,668 @@
+/* atsa-export.c
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include <cairo-pdf.h>
+#include <errno.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+
+#include "atsa-export.h"
+#include "atsa-rich-text.h"
+#include "atsa-worker-pool.h"
+
+/* Exam variants shuffle the order of the questions and of their options.
+ * A variant is fully determined by the seed and its number, so variants can
+ * be produced on any thread in any order and still come out identical.
+ *
+ * Every document is a header block followed by one block per question,
+ * laid out top to bottom and moved to the next page whenever a block does
+ * not fit. Exporting writes each variant and its answer key to their own
+ * PDF files from a pool of one worker per core; cairo writes out each page
+ * when it is finished, so memory does not grow with the page count.
+ * Printing goes through the same block layout on the print context.
+ */
+
+/* A4, in points */
+#define PAGE_WIDTH    595.0
+#define PAGE_HEIGHT   842.0
+#define PAGE_MARGIN    56.0
+#define BLOCK_SPACING  12.0
+#define BODY_FONT     "Serif 11"
+#define FOOTER_FONT   "Sans 8"
+
+typedef struct
+{
+	AtsaQuestionBank  *bank;
+	guint              number;
+	/* Bank indices of the questions, in exam order */
+	guint             *order;
+	/* Per exam position, bank indices of the choices in exam order */
+	guint            **choice_order;
+} ExamVariant;
+
+static void
+shuffle (GRand *rng,
+         guint *array,
+         guint  len)
+{
+	for (guint i = len; i > 1; i--)
+	{
+		guint j = g_rand_int_range (rng, 0, i);
+		guint tmp = array[i - 1];
+
+		array[i - 1] = array[j];
+		array[j] = tmp;
+	}
+}
+
+static ExamVariant *
+exam_variant_new (AtsaQuestionBank *bank,
+                  guint             number,
+                  guint32           seed)
+{
+	ExamVariant *self = g_new0 (ExamVariant, 1);
+	guint n_questions = atsa_question_bank_get_n_questions (bank);
+	guint32 seed_array[] = { seed, number };
+	GRand *rng = g_rand_new_with_seed_array (seed_array, G_N_ELEMENTS (seed_array));
+
+	self->bank = atsa_question_bank_ref (bank);
+	self->number = number;
+	self->order = g_new (guint, MAX (n_questions, 1));
+	self->choice_order = g_new0 (guint *, n_questions + 1);
+
+	for (guint i = 0; i < n_questions; i++)
+		self->order[i] = i;
+	shuffle (rng, self->order, n_questions);
+
+	for (guint i = 0; i < n_questions; i++)
+	{
+		const AtsaQuestion *question = atsa_question_bank_get_question (bank, self->order[i]);
+		guint n_choices = g_strv_length (question->choices);
+
+		self->choice_order[i] = g_new (guint, MAX (n_choices, 1));
+		for (guint j = 0; j < n_choices; j++)
+			self->choice_order[i][j] = j;
+		shuffle (rng, self->choice_order[i], n_choices);
+	}
+
+	g_rand_free (rng);
+
+	return self;
+}
+
+static void
+exam_variant_free (ExamVariant *self)
+{
+	for (guint i = 0; self->choice_order[i] != NULL; i++)
+		g_free (self->choice_order[i]);
+	g_free (self->choice_order);
+	g_free (self->order);
+	atsa_question_bank_unref (self->bank);
+	g_free (self);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (ExamVariant, exam_variant_free)
+
+static guint
+exam_variant_get_n_blocks (ExamVariant *self)
+{
+	return atsa_question_bank_get_n_questions (self->bank) + 1;
+}
+
+/* Returns the markup of block @index, 0 being the header */
+static char *
+exam_variant_format_block (ExamVariant *self,
+                           guint        index,
+                           gboolean     answer_key)
+{
+	const AtsaQuestion *question;
+	const guint *choice_order;
+	GString *markup;
+
+	if (index == 0)
+	{
+		g_autofree char *file_name = g_path_get_basename (atsa_question_bank_get_path (self->bank));
+		g_autofree char *title = NULL;
+
+		if (answer_key)
+		{
+			/* Translators: the first %s is the question file name, %u the variant number */
+			title = g_strdup_printf (_("%s — Answer Key, Variant %u"), file_name, self->number);
+
+			return g_markup_printf_escaped ("<b>%s</b>", title);
+		}
+
+		/* Translators: the first %s is the question file name, %u the variant number */
+		title = g_strdup_printf (_("%s — Variant %u"), file_name, self->number);
+
+		return g_markup_printf_escaped ("<b>%s</b>\n\n%s", title,
+		                                /* Translators: blanks students fill in on printed exams */
+		                                _("Name: ______________________    Class: __________"));
+	}
+
+	question = atsa_question_bank_get_question (self->bank, self->order[index - 1]);
+	choice_order = self->choice_order[index - 1];
+
+	if (!answer_key)
+		return atsa_question_to_markup (question, index, choice_order, TRUE);
+
+	markup = g_string_new (NULL);
+	g_string_append_printf (markup, "<b>%u.</b> ", index);
+
+	for (guint i = 0; question->choices[i] != NULL; i++)
+	{
+		guint choice = choice_order[i];
+
+		if (question->type == QUESTION_TYPE_MULTIPLE_CHOICE)
+		{
+			if (choice == question->correct_answer)
+				g_string_append_printf (markup, "%c", 'A' + (i % 26));
+		}
+		else if (question->type == QUESTION_TYPE_TRUE_FALSE)
+		{
+			g_autofree char *answer = g_markup_escape_text (question->tf_answers[choice] ? _("T") : _("F"), -1);
+
+			g_string_append_printf (markup, "%u) %s  ", i + 1, answer);
+		}
+	}
+
+	return g_string_free (markup, FALSE);
+}
+
+static PangoLayout *
+create_page_layout (cairo_t    *cr,
+                    const char *markup,
+                    const char *font,
+                    double      width)
+{
+	PangoLayout *layout = atsa_rich_text_create_layout (cr, markup, font, (int) width);
+
+	/* Cairo units are points here, make font sizes match them */
+	pango_cairo_context_set_resolution (pango_layout_get_context (layout), 72);
+	pango_layout_context_changed (layout);
+
+	return layout;
+}
+
+static double
+layout_get_height (PangoLayout *layout)
+{
+	int height;
+
+	pango_layout_get_size (layout, NULL, &height);
+
+	return (double) height / PANGO_SCALE;
+}
+
+static gboolean
+needs_page_break (double y,
+                  double block_height,
+                  double page_height)
+{
+	/* A block taller than a whole page is placed anyway rather than
+	 * producing empty pages forever.
+	 */
+	return y > PAGE_MARGIN && y + block_height > page_height - PAGE_MARGIN;
+}
+
+static void
+draw_footer (cairo_t     *cr,
+             ExamVariant *variant,
+             gboolean     answer_key,
+             guint        page,
+             double       page_width,
+             double       page_height)
+{
+	g_autofree char *markup = NULL;
+	PangoLayout *layout;
+	int width;
+
+	if (answer_key)
+		markup = g_markup_printf_escaped (_("Answer key, variant %u — page %u"), variant->number, page);
+	else
+		markup = g_markup_printf_escaped (_("Variant %u — page %u"), variant->number, page);
+
+	layout = create_page_layout (cr, markup, FOOTER_FONT, -1);
+	pango_layout_get_size (layout, &width, NULL);
+	cairo_move_to (cr,
+	               (page_width - (double) width / PANGO_SCALE) / 2,
+	               page_height - PAGE_MARGIN / 2);
+	pango_cairo_show_layout (cr, layout);
+	g_object_unref (layout);
+}
+
+static char *
+document_path (const char *directory,
+               guint       number,
+               gboolean    answer_key)
+{
+	g_autofree char *basename = NULL;
+
+	basename = g_strdup_printf (answer_key ? "variant-%03u-key.pdf" : "variant-%03u.pdf", number);
+
+	return g_build_filename (directory, basename, NULL);
+}
+
+static gboolean
+write_document (ExamVariant   *variant,
+                gboolean       answer_key,
+                const char    *path,
+                GCancellable  *cancellable,
+                GError       **error)
+{
+	cairo_surface_t *surface;
+	cairo_t *cr;
+	cairo_status_t status;
+	guint n_blocks = exam_variant_get_n_blocks (variant);
+	double content_width = PAGE_WIDTH - 2 * PAGE_MARGIN;
+	double y = PAGE_MARGIN;
+	guint page = 1;
+
+	surface = cairo_pdf_surface_create (path, PAGE_WIDTH, PAGE_HEIGHT);
+	cr = cairo_create (surface);
+
+	for (guint i = 0; i < n_blocks; i++)
+	{
+		g_autofree char *markup = NULL;
+		PangoLayout *layout;
+		double height;
+
+		if (g_cancellable_is_cancelled (cancellable))
+			break;
+
+		markup = exam_variant_format_block (variant, i, answer_key);
+		layout = create_page_layout (cr, markup, BODY_FONT, content_width);
+		height = layout_get_height (layout);
+
+		if (needs_page_break (y, height, PAGE_HEIGHT))
+		{
+			draw_footer (cr, variant, answer_key, page++, PAGE_WIDTH, PAGE_HEIGHT);
+			cairo_show_page (cr);
+			y = PAGE_MARGIN;
+		}
+
+		cairo_move_to (cr, PAGE_MARGIN, y);
+		pango_cairo_show_layout (cr, layout);
+		g_object_unref (layout);
+
+		y += height + BLOCK_SPACING;
+	}
+
+	draw_footer (cr, variant, answer_key, page, PAGE_WIDTH, PAGE_HEIGHT);
+	cairo_destroy (cr);
+	cairo_surface_finish (surface);
+	status = cairo_surface_status (surface);
+	cairo_surface_destroy (surface);
+
+	if (g_cancellable_set_error_if_cancelled (cancellable, error))
+	{
+		g_unlink (path);
+		return FALSE;
+	}
+
+	if (status != CAIRO_STATUS_SUCCESS)
+	{
+		g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+		             _("Failed to write “%s”: %s"), path, cairo_status_to_string (status));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+typedef struct
+{
+	AtsaQuestionBank *bank;
+	guint             n_variants;
+	guint32           seed;
+	char             *directory;
+} ExportData;
+
+static void
+export_data_free (ExportData *data)
+{
+	atsa_question_bank_unref (data->bank);
+	g_free (data->directory);
+	g_free (data);
+}
+
+static ExportData *
+export_data_new (AtsaQuestionBank *bank,
+                 guint             n_variants,
+                 guint32           seed,
+                 const char       *directory)
+{
+	ExportData *data = g_new0 (ExportData, 1);
+
+	data->bank = atsa_question_bank_ref (bank);
+	data->n_variants = n_variants;
+	data->seed = seed;
+	data->directory = g_strdup (directory);
+
+	return data;
+}
+
+static gboolean
+export_variant_func (guint          index,
+                     gpointer       user_data,
+                     GCancellable  *cancellable,
+                     GError       **error)
+{
+	ExportData *data = user_data;
+	guint number = index + 1;
+	g_autoptr(ExamVariant) variant = NULL;
+	g_autofree char *exam_path = NULL;
+	g_autofree char *key_path = NULL;
+
+	variant = exam_variant_new (data->bank, number, data->seed);
+	exam_path = document_path (data->directory, number, FALSE);
+	key_path = document_path (data->directory, number, TRUE);
+
+	return write_document (variant, FALSE, exam_path, cancellable, error) &&
+	       write_document (variant, TRUE, key_path, cancellable, error);
+}
+
+static gboolean
+export_variants (ExportData    *data,
+                 GCancellable  *cancellable,
+                 GError       **error)
+{
+	if (g_mkdir_with_parents (data->directory, 0755) != 0)
+	{
+		int errsv = errno;
+
+		g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+		             _("Failed to create “%s”: %s"), data->directory, g_strerror (errsv));
+		return FALSE;
+	}
+
+	return atsa_worker_pool_run (data->n_variants, export_variant_func, data, cancellable, error);
+}
+
+/**
+ * atsa_export_variants:
+ * @bank: the questions to export
+ * @n_variants: number of variants
+ * @seed: seed the variants are derived from
+ * @directory: directory to write the PDF files to
+ * @cancellable: (nullable): a #GCancellable
+ * @error: return location for a #GError
+ *
+ * Writes variant-NNN.pdf and variant-NNN-key.pdf for every variant, using
+ * one worker thread per core. Blocks until all files are written.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+atsa_export_variants (AtsaQuestionBank  *bank,
+                      guint              n_variants,
+                      guint32            seed,
+                      const char        *directory,
+                      GCancellable      *cancellable,
+                      GError           **error)
+{
+	ExportData *data;
+	gboolean ret;
+
+	g_return_val_if_fail (bank != NULL, FALSE);
+	g_return_val_if_fail (directory != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	data = export_data_new (bank, n_variants, seed, directory);
+	ret = export_variants (data, cancellable, error);
+	export_data_free (data);
+
+	return ret;
+}
+
+static void
+export_variants_thread (GTask        *task,
+                        gpointer      source_object,
+                        gpointer      task_data,
+                        GCancellable *cancellable)
+{
+	GError *error = NULL;
+
+	if (export_variants (task_data, cancellable, &error))
+		g_task_return_boolean (task, TRUE);
+	else
+		g_task_return_error (task, error);
+}
+
+void
+atsa_export_variants_async (AtsaQuestionBank    *bank,
+                            guint                n_variants,
+                            guint32              seed,
+                            const char          *directory,
+                            GCancellable        *cancellable,
+                            GAsyncReadyCallback  callback,
+                            gpointer             user_data)
+{
+	GTask *task;
+
+	g_return_if_fail (bank != NULL);
+	g_return_if_fail (directory != NULL);
+
+	task = g_task_new (NULL, cancellable, callback, user_data);
+	g_task_set_source_tag (task, atsa_export_variants_async);
+	g_task_set_task_data (task,
+	                      export_data_new (bank, n_variants, seed, directory),
+	                      (GDestroyNotify) export_data_free);
+	g_task_run_in_thread (task, export_variants_thread);
+	g_object_unref (task);
+}
+
+gboolean
+atsa_export_variants_finish (GAsyncResult  *result,
+                             GError       **error)
+{
+	g_return_val_if_fail (g_task_is_valid (result, NULL), FALSE);
+
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+typedef struct
+{
+	guint    number;
+	gboolean answer_key;
+	guint    page;
+	guint    first_block;
+	guint    end_block;
+} PrintPage;
+
+typedef struct
+{
+	AtsaQuestionBank *bank;
+	guint             n_variants;
+	guint32           seed;
+	gboolean          answer_keys;
+
+	GArray           *pages;
+	/* Documents paginated so far, one variant or answer key each */
+	guint             n_paginated;
+	/* The variant the last drawn page belonged to */
+	ExamVariant      *variant;
+} PrintData;
+
+static void
+print_data_free (PrintData *data)
+{
+	atsa_question_bank_unref (data->bank);
+	g_clear_pointer (&data->pages, g_array_unref);
+	g_clear_pointer (&data->variant, exam_variant_free);
+	g_free (data);
+}
+
+static ExamVariant *
+print_data_get_variant (PrintData *data,
+                        guint      number)
+{
+	if (data->variant == NULL || data->variant->number != number)
+	{
+		g_clear_pointer (&data->variant, exam_variant_free);
+		data->variant = exam_variant_new (data->bank, number, data->seed);
+	}
+
+	return data->variant;
+}
+
+static void
+begin_print_cb (GtkPrintOperation *operation,
+                GtkPrintContext   *context,
+                PrintData         *data)
+{
+	g_array_set_size (data->pages, 0);
+	data->n_paginated = 0;
+}
+
+/* Paginates one document per call so long jobs keep the dialog responsive */
+static gboolean
+paginate_cb (GtkPrintOperation *operation,
+             GtkPrintContext   *context,
+             PrintData         *data)
+{
+	guint docs_per_variant = data->answer_keys ? 2 : 1;
+	cairo_t *cr = gtk_print_context_get_cairo_context (context);
+	double page_width = gtk_print_context_get_width (context);
+	double page_height = gtk_print_context_get_height (context);
+	ExamVariant *variant;
+	PrintPage page = { 0, };
+	guint n_blocks;
+	double y = PAGE_MARGIN;
+
+	if (data->n_paginated == data->n_variants * docs_per_variant)
+	{
+		gtk_print_operation_set_n_pages (operation, MAX (data->pages->len, 1));
+		return TRUE;
+	}
+
+	page.number = data->n_paginated / docs_per_variant + 1;
+	page.answer_key = data->n_paginated % docs_per_variant == 1;
+	page.page = 1;
+	data->n_paginated++;
+
+	variant = print_data_get_variant (data, page.number);
+	n_blocks = exam_variant_get_n_blocks (variant);
+
+	for (guint i = 0; i < n_blocks; i++)
+	{
+		g_autofree char *markup = exam_variant_format_block (variant, i, page.answer_key);
+		PangoLayout *layout = create_page_layout (cr, markup, BODY_FONT, page_width - 2 * PAGE_MARGIN);
+		double height = layout_get_height (layout);
+
+		g_object_unref (layout);
+
+		if (needs_page_break (y, height, page_height))
+		{
+			page.end_block = i;
+			g_array_append_val (data->pages, page);
+			page.page++;
+			page.first_block = i;
+			y = PAGE_MARGIN;
+		}
+
+		y += height + BLOCK_SPACING;
+	}
+
+	page.end_block = n_blocks;
+	g_array_append_val (data->pages, page);
+
+	return FALSE;
+}
+
+static void
+draw_page_cb (GtkPrintOperation *operation,
+              GtkPrintContext   *context,
+              int                page_nr,
+              PrintData         *data)
+{
+	cairo_t *cr = gtk_print_context_get_cairo_context (context);
+	double page_width = gtk_print_context_get_width (context);
+	double page_height = gtk_print_context_get_height (context);
+	const PrintPage *page;
+	ExamVariant *variant;
+	double y = PAGE_MARGIN;
+
+	if ((guint) page_nr >= data->pages->len)
+		return;
+
+	page = &g_array_index (data->pages, PrintPage, page_nr);
+	variant = print_data_get_variant (data, page->number);
+
+	for (guint i = page->first_block; i < page->end_block; i++)
+	{
+		g_autofree char *markup = exam_variant_format_block (variant, i, page->answer_key);
+		PangoLayout *layout = create_page_layout (cr, markup, BODY_FONT, page_width - 2 * PAGE_MARGIN);
+
+		cairo_move_to (cr, PAGE_MARGIN, y);
+		pango_cairo_show_layout (cr, layout);
+		y += layout_get_height (layout) + BLOCK_SPACING;
+		g_object_unref (layout);
+	}
+
+	draw_footer (cr, variant, page->answer_key, page->page, page_width, page_height);
+}
+
+/**
+ * atsa_export_print_operation_new:
+ * @bank: the questions to print
+ * @n_variants: number of variants
+ * @seed: seed the variants are derived from
+ * @answer_keys: whether to print each variant's answer key after it
+ *
+ * Creates a print operation producing the same pages as
+ * atsa_export_variants(), one document after the other.
+ *
+ * Returns: (transfer full): a new #GtkPrintOperation
+ */
+GtkPrintOperation *
+atsa_export_print_operation_new (AtsaQuestionBank *bank,
+                                 guint             n_variants,
+                                 guint32           seed,
+                                 gboolean          answer_keys)
+{
+	GtkPrintOperation *operation;
+	PrintData *data;
+
+	g_return_val_if_fail (bank != NULL, NULL);
+
+	data = g_new0 (PrintData, 1);
+	data->bank = atsa_question_bank_ref (bank);
+	data->n_variants = MAX (n_variants, 1);
+	data->seed = seed;
+	data->answer_keys = answer_keys;
+	data->pages = g_array_new (FALSE, FALSE, sizeof (PrintPage));
+
+	operation = gtk_print_operation_new ();
+	gtk_print_operation_set_unit (operation, GTK_UNIT_POINTS);
+	/* Margins are ours, so printed pages match the exported PDFs */
+	gtk_print_operation_set_use_full_page (operation, TRUE);
+	gtk_print_operation_set_embed_page_setup (operation, TRUE);
+
+	g_object_set_data_full (G_OBJECT (operation), "atsa-print-data",
+	                        data, (GDestroyNotify) print_data_free);
+	g_signal_connect (operation, "begin-print", G_CALLBACK (begin_print_cb), data);
+	g_signal_connect (operation, "paginate", G_CALLBACK (paginate_cb), data);
+	g_signal_connect (operation, "draw-page", G_CALLBACK (draw_page_cb), data);
+
+	return operation;
+}
@@ -0,0 +1,50 @@
+/* atsa-export.h
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+#include "atsa-question-bank.h"
+
+G_BEGIN_DECLS
+
+gboolean           atsa_export_variants                (AtsaQuestionBank     *bank,
+                                                        guint                 n_variants,
+                                                        guint32               seed,
+                                                        const char           *directory,
+                                                        GCancellable         *cancellable,
+                                                        GError              **error);
+void               atsa_export_variants_async          (AtsaQuestionBank     *bank,
+                                                        guint                 n_variants,
+                                                        guint32               seed,
+                                                        const char           *directory,
+                                                        GCancellable         *cancellable,
+                                                        GAsyncReadyCallback   callback,
+                                                        gpointer              user_data);
+gboolean           atsa_export_variants_finish         (GAsyncResult         *result,
+                                                        GError              **error);
+
+GtkPrintOperation *atsa_export_print_operation_new     (AtsaQuestionBank     *bank,
+                                                        guint                 n_variants,
+                                                        guint32               seed,
+                                                        gboolean              answer_keys);
+
+G_END_DECLS
@@ -0,0 +1,393 @@
+/* atsa-question-bank.c
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include <gio/gio.h>
+#include <glib/gi18n.h>
+
+#include "atsa-bank-format.h"
+#include "atsa-question-bank.h"
+#include "atsa-rich-text.h"
+
+/* An immutable, reference counted copy of the questions in one file.
+ *
+ * The Rust library keeps a single global set of questions which is replaced
+ * on every load_questions_into_memory() call, so it cannot be shared between
+ * windows or touched from worker threads. Copying the questions out right
+ * after loading gives everything else a snapshot that is safe to read from
+ * any thread. Files in the exchange formats of atsa-bank-format.c are read
+ * record by record instead of going through the Rust library.
+ */
+struct _AtsaQuestionBank
+{
+	gatomicrefcount  ref_count;
+	char            *path;
+	GPtrArray       *questions;
+};
+
+G_DEFINE_BOXED_TYPE (AtsaQuestionBank, atsa_question_bank,
+                     atsa_question_bank_ref, atsa_question_bank_unref)
+
+/* Serialises access to the global question store of the Rust library */
+G_LOCK_DEFINE_STATIC (rust_questions);
+
+AtsaQuestion *
+atsa_question_copy (const AtsaQuestion *question)
+{
+	AtsaQuestion *copy;
+
+	g_return_val_if_fail (question != NULL, NULL);
+
+	copy = g_new0 (AtsaQuestion, 1);
+	copy->type = question->type;
+	copy->text = g_strdup (question->text);
+	copy->choices = g_strdupv (question->choices);
+	copy->correct_answer = question->correct_answer;
+	if (question->tf_answers != NULL)
+		copy->tf_answers = g_memdup2 (question->tf_answers,
+		                              MAX (g_strv_length (question->choices), 1));
+
+	return copy;
+}
+
+void
+atsa_question_free (AtsaQuestion *question)
+{
+	if (question == NULL)
+		return;
+
+	g_free (question->text);
+	g_strfreev (question->choices);
+	g_free (question->tf_answers);
+	g_free (question);
+}
+
+/**
+ * atsa_question_to_markup:
+ * @question: a question
+ * @number: number to put in front of the question, or 0 for none
+ * @choice_order: (nullable): indices into @question->choices in the order
+ *   to show them, or %NULL for file order
+ * @answer_blanks: whether to leave room for circling T or F after each
+ *   true/false statement, for printed exams
+ *
+ * Lays out a question as its text followed by its options (lettered) or
+ * statements (numbered), one per line. Every field is converted from the
+ * rich text syntax on its own, so an unbalanced `*` or `$` in one field
+ * can't take over the next.
+ *
+ * Returns: (transfer full): Pango markup for @question
+ */
+char *
+atsa_question_to_markup (const AtsaQuestion *question,
+                         guint               number,
+                         const guint        *choice_order,
+                         gboolean            answer_blanks)
+{
+	g_autofree char *text = NULL;
+	GString *markup;
+
+	g_return_val_if_fail (question != NULL, NULL);
+
+	markup = g_string_new (NULL);
+
+	if (number > 0)
+		g_string_append_printf (markup, "<b>%u.</b> ", number);
+
+	text = atsa_rich_text_to_markup (question->text);
+	g_string_append (markup, text);
+
+	for (guint i = 0; question->choices[i] != NULL; i++)
+	{
+		guint choice = choice_order != NULL ? choice_order[i] : i;
+		g_autofree char *choice_markup = atsa_rich_text_to_markup (question->choices[choice]);
+
+		if (question->type == QUESTION_TYPE_MULTIPLE_CHOICE)
+			g_string_append_printf (markup, "\n    %c. %s", 'A' + (i % 26), choice_markup);
+		else
+			g_string_append_printf (markup, "\n    %u) %s%s", i + 1, choice_markup,
+			                        answer_blanks ? "    T / F" : "");
+	}
+
+	return g_string_free (markup, FALSE);
+}
+
+static GStrv
+copy_rust_string_array (char   **array,
+                        size_t   count)
+{
+	GStrv copy = g_new0 (char *, count + 1);
+
+	for (size_t i = 0; i < count; i++)
+		copy[i] = g_strdup (array[i]);
+
+	free_string_array (array, count);
+
+	return copy;
+}
+
+static AtsaQuestion *
+copy_rust_question (size_t index)
+{
+	AtsaQuestion *question = g_new0 (AtsaQuestion, 1);
+	char *text;
+	char **array;
+	size_t count = 0;
+
+	question->type = get_question_type (index);
+
+	text = get_question_text (index);
+	question->text = g_strdup (text != NULL ? text : "");
+	if (text != NULL)
+		free_cstring (text);
+
+	switch (question->type)
+	{
+	case QUESTION_TYPE_MULTIPLE_CHOICE:
+		array = get_mc_options (index, &count);
+		question->choices = array != NULL ? copy_rust_string_array (array, count)
+		                                   : g_new0 (char *, 1);
+		question->correct_answer = get_mc_correct_answer (index);
+		break;
+
+	case QUESTION_TYPE_TRUE_FALSE:
+		{
+			unsigned char *answers;
+			size_t answer_count = 0;
+
+			array = get_tf_statements (index, &count);
+			question->choices = array != NULL ? copy_rust_string_array (array, count)
+			                                   : g_new0 (char *, 1);
+
+			answers = get_tf_correct_answers (index, &answer_count);
+			question->tf_answers = g_new0 (guint8, MAX (count, 1));
+			if (answers != NULL)
+			{
+				memcpy (question->tf_answers, answers, MIN (count, answer_count));
+				free_bool_array (answers);
+			}
+		}
+		break;
+
+	case QUESTION_TYPE_NONE:
+	default:
+		question->choices = g_new0 (char *, 1);
+		break;
+	}
+
+	return question;
+}
+
+static AtsaQuestionBank *
+atsa_question_bank_new (const char *path,
+                        guint       reserved_size)
+{
+	AtsaQuestionBank *self = g_new0 (AtsaQuestionBank, 1);
+
+	g_atomic_ref_count_init (&self->ref_count);
+	self->path = g_strdup (path);
+	self->questions = g_ptr_array_new_full (reserved_size, (GDestroyNotify) atsa_question_free);
+
+	return self;
+}
+
+static AtsaQuestionBank *
+load_from_reader (const char  *path,
+                  GError     **error)
+{
+	g_autoptr(AtsaBankReader) reader = NULL;
+	AtsaQuestionBank *self;
+	AtsaQuestion *question;
+	GError *local_error = NULL;
+
+	reader = atsa_bank_reader_new (path, error);
+	if (reader == NULL)
+		return NULL;
+
+	self = atsa_question_bank_new (path, 0);
+
+	while ((question = atsa_bank_reader_next (reader, &local_error)) != NULL)
+		g_ptr_array_add (self->questions, question);
+
+	if (local_error != NULL)
+	{
+		g_propagate_error (error, local_error);
+		atsa_question_bank_unref (self);
+		return NULL;
+	}
+
+	return self;
+}
+
+static AtsaQuestionBank *
+load_from_rust (const char  *path,
+                GError     **error)
+{
+	AtsaQuestionBank *self;
+	size_t n_questions;
+
+	G_LOCK (rust_questions);
+
+	if (load_questions_into_memory (path) != 0)
+	{
+		G_UNLOCK (rust_questions);
+		g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+		             _("Failed to load questions from “%s”"), path);
+		return NULL;
+	}
+
+	n_questions = get_total_question_count ();
+	self = atsa_question_bank_new (path, n_questions);
+
+	for (size_t i = 0; i < n_questions; i++)
+		g_ptr_array_add (self->questions, copy_rust_question (i));
+
+	G_UNLOCK (rust_questions);
+
+	return self;
+}
+
+/**
+ * atsa_question_bank_load:
+ * @path: path of a question file
+ * @error: return location for a #GError
+ *
+ * Loads @path and takes a snapshot of its questions. YAML goes through the
+ * Rust library, CSV, JSON and GIFT files are imported by their extension.
+ *
+ * Returns: (transfer full): the new bank, or %NULL on error
+ */
+AtsaQuestionBank *
+atsa_question_bank_load (const char  *path,
+                         GError     **error)
+{
+	g_return_val_if_fail (path != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	switch (atsa_bank_format_from_path (path))
+	{
+	case ATSA_BANK_FORMAT_CSV:
+	case ATSA_BANK_FORMAT_JSON:
+	case ATSA_BANK_FORMAT_GIFT:
+		return load_from_reader (path, error);
+
+	case ATSA_BANK_FORMAT_YAML:
+	case ATSA_BANK_FORMAT_UNKNOWN:
+	default:
+		return load_from_rust (path, error);
+	}
+}
+
+AtsaQuestionBank *
+atsa_question_bank_ref (AtsaQuestionBank *self)
+{
+	g_return_val_if_fail (self != NULL, NULL);
+
+	g_atomic_ref_count_inc (&self->ref_count);
+
+	return self;
+}
+
+void
+atsa_question_bank_unref (AtsaQuestionBank *self)
+{
+	g_return_if_fail (self != NULL);
+
+	if (g_atomic_ref_count_dec (&self->ref_count))
+	{
+		g_free (self->path);
+		g_ptr_array_unref (self->questions);
+		g_free (self);
+	}
+}
+
+const char *
+atsa_question_bank_get_path (AtsaQuestionBank *self)
+{
+	g_return_val_if_fail (self != NULL, NULL);
+
+	return self->path;
+}
+
+guint
+atsa_question_bank_get_n_questions (AtsaQuestionBank *self)
+{
+	g_return_val_if_fail (self != NULL, 0);
+
+	return self->questions->len;
+}
+
+const AtsaQuestion *
+atsa_question_bank_get_question (AtsaQuestionBank *self,
+                                 guint             index)
+{
+	g_return_val_if_fail (self != NULL, NULL);
+	g_return_val_if_fail (index < self->questions->len, NULL);
+
+	return g_ptr_array_index (self->questions, index);
+}
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME        0x100000001b3ULL
+
+static guint64
+fnv1a_update (guint64     hash,
+              const char *data,
+              gsize       len)
+{
+	for (gsize i = 0; i < len; i++)
+	{
+		hash ^= (guchar) data[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+/**
+ * atsa_question_content_hash:
+ * @question: a question
+ *
+ * Hashes what a question asks, independent of which file it is in and where.
+ * Reordering, adding or removing other questions keeps the hash, editing
+ * the question itself changes it. Never returns 0, so callers may use 0 to
+ * mean "no question".
+ *
+ * Returns: a stable 64-bit hash of @question
+ */
+guint64
+atsa_question_content_hash (const AtsaQuestion *question)
+{
+	guint64 hash = FNV_OFFSET_BASIS;
+	guchar type;
+
+	g_return_val_if_fail (question != NULL, 0);
+
+	type = (guchar) question->type;
+	hash = fnv1a_update (hash, (const char *) &type, 1);
+	/* Strings are hashed with their terminator, so fields can't run together */
+	hash = fnv1a_update (hash, question->text, strlen (question->text) + 1);
+
+	for (guint i = 0; question->choices[i] != NULL; i++)
+		hash = fnv1a_update (hash, question->choices[i], strlen (question->choices[i]) + 1);
+
+	return hash != 0 ? hash : 1;
+}
@@ -0,0 +1,69 @@
+/* atsa-question-bank.h
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+#include "rust_questions_api.h"
+
+G_BEGIN_DECLS
+
+typedef struct
+{
+	QuestionTypeC  type;
+	char          *text;
+	/* Options for multiple choice, statements for true/false */
+	GStrv          choices;
+	/* Index into @choices for multiple choice */
+	guint          correct_answer;
+	/* One entry per statement for true/false, NULL otherwise */
+	guint8        *tf_answers;
+} AtsaQuestion;
+
+AtsaQuestion       *atsa_question_copy                 (const AtsaQuestion *question);
+void                atsa_question_free                 (AtsaQuestion       *question);
+guint64             atsa_question_content_hash         (const AtsaQuestion *question);
+char               *atsa_question_to_markup            (const AtsaQuestion *question,
+                                                        guint               number,
+                                                        const guint        *choice_order,
+                                                        gboolean            answer_blanks);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (AtsaQuestion, atsa_question_free)
+
+typedef struct _AtsaQuestionBank AtsaQuestionBank;
+
+#define ATSA_TYPE_QUESTION_BANK (atsa_question_bank_get_type ())
+
+GType               atsa_question_bank_get_type        (void) G_GNUC_CONST;
+
+AtsaQuestionBank   *atsa_question_bank_load            (const char        *path,
+                                                        GError           **error);
+AtsaQuestionBank   *atsa_question_bank_ref             (AtsaQuestionBank  *self);
+void                atsa_question_bank_unref           (AtsaQuestionBank  *self);
+
+const char         *atsa_question_bank_get_path        (AtsaQuestionBank  *self);
+guint               atsa_question_bank_get_n_questions (AtsaQuestionBank  *self);
+const AtsaQuestion *atsa_question_bank_get_question    (AtsaQuestionBank  *self,
+                                                        guint              index);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (AtsaQuestionBank, atsa_question_bank_unref)
+
+G_END_DECLS
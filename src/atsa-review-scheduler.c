@@ -0,0 +1,289 @@
+/* atsa-review-scheduler.c
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "atsa-due-queue.h"
+#include "atsa-review-scheduler.h"
+
+/* Picks questions for self-study across every loaded bank using SM-2.
+ *
+ * Questions are identified by their content hash, which is also the key of
+ * their state in the AtsaReviewStore, so the history follows a question
+ * into edited or merged banks. Only questions due before the end of the
+ * current window (one day) are kept in the AtsaDueQueue; everything due
+ * later stays on disk until the window moves on. Picking the next question
+ * and recording an answer are O(log n) in the size of the window.
+ */
+
+#define WINDOW_SECONDS   (24 * 60 * 60)
+#define DAY_SECONDS      (24 * 60 * 60)
+/* A forgotten question comes back within the same session */
+#define RELEARN_SECONDS  (10 * 60)
+#define DEFAULT_EASE     2500
+#define MIN_EASE         1300
+
+typedef struct
+{
+	guint64           hash;
+	AtsaQuestionBank *bank;
+	guint             index;
+} Card;
+
+struct _AtsaReviewScheduler
+{
+	AtsaReviewStore *store;
+	AtsaDueQueue    *queue;
+	/* &card->hash → Card, every question of every loaded bank */
+	GHashTable      *cards;
+	gint64           window_end;
+};
+
+static void
+card_free (Card *card)
+{
+	atsa_question_bank_unref (card->bank);
+	g_free (card);
+}
+
+static void
+atsa_review_scheduler_enqueue (AtsaReviewScheduler *self,
+                               Card                *card,
+                               gint64               now)
+{
+	AtsaReviewRecord record;
+	gint64 due = now;
+
+	/* Questions without a record have never been studied and are due now */
+	if (atsa_review_store_lookup (self->store, card->hash, &record))
+		due = record.due;
+
+	if (due < self->window_end)
+		atsa_due_queue_set (self->queue, card->hash, due);
+}
+
+static void
+atsa_review_scheduler_refill (AtsaReviewScheduler *self,
+                              gint64               now)
+{
+	GHashTableIter iter;
+	Card *card;
+
+	self->window_end = now + WINDOW_SECONDS;
+	atsa_due_queue_clear (self->queue);
+
+	g_hash_table_iter_init (&iter, self->cards);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &card))
+		atsa_review_scheduler_enqueue (self, card, now);
+}
+
+/**
+ * atsa_review_scheduler_new:
+ * @store: (transfer full): where review state is kept
+ *
+ * Returns: (transfer full): a new #AtsaReviewScheduler
+ */
+AtsaReviewScheduler *
+atsa_review_scheduler_new (AtsaReviewStore *store)
+{
+	AtsaReviewScheduler *self;
+
+	g_return_val_if_fail (store != NULL, NULL);
+
+	self = g_new0 (AtsaReviewScheduler, 1);
+	self->store = store;
+	self->queue = atsa_due_queue_new ();
+	self->cards = g_hash_table_new_full (g_int64_hash, g_int64_equal,
+	                                     NULL, (GDestroyNotify) card_free);
+
+	return self;
+}
+
+void
+atsa_review_scheduler_free (AtsaReviewScheduler *self)
+{
+	if (self == NULL)
+		return;
+
+	g_hash_table_unref (self->cards);
+	atsa_due_queue_free (self->queue);
+	atsa_review_store_close (self->store);
+	g_free (self);
+}
+
+/**
+ * atsa_review_scheduler_add_bank:
+ * @self: a #AtsaReviewScheduler
+ * @bank: questions to study
+ * @now: the current time in seconds since the epoch
+ *
+ * Makes the questions of @bank available for review. A question that is
+ * already known from another bank is only scheduled once.
+ */
+void
+atsa_review_scheduler_add_bank (AtsaReviewScheduler *self,
+                                AtsaQuestionBank    *bank,
+                                gint64               now)
+{
+	guint n_questions;
+
+	g_return_if_fail (self != NULL);
+	g_return_if_fail (bank != NULL);
+
+	if (self->window_end == 0)
+		self->window_end = now + WINDOW_SECONDS;
+
+	n_questions = atsa_question_bank_get_n_questions (bank);
+
+	for (guint i = 0; i < n_questions; i++)
+	{
+		guint64 hash = atsa_question_content_hash (atsa_question_bank_get_question (bank, i));
+		Card *card;
+
+		if (g_hash_table_contains (self->cards, &hash))
+			continue;
+
+		card = g_new (Card, 1);
+		card->hash = hash;
+		card->bank = atsa_question_bank_ref (bank);
+		card->index = i;
+		g_hash_table_insert (self->cards, &card->hash, card);
+
+		atsa_review_scheduler_enqueue (self, card, now);
+	}
+}
+
+/**
+ * atsa_review_scheduler_next:
+ * @self: a #AtsaReviewScheduler
+ * @now: the current time in seconds since the epoch
+ * @bank: (out) (transfer none): return location for the bank of the question
+ * @index: (out): return location for the index of the question in @bank
+ * @hash: (out): return location for the hash to pass to
+ *   atsa_review_scheduler_record()
+ *
+ * Finds the question that has been due the longest.
+ *
+ * Returns: %FALSE if nothing is due
+ */
+gboolean
+atsa_review_scheduler_next (AtsaReviewScheduler  *self,
+                            gint64                now,
+                            AtsaQuestionBank    **bank,
+                            guint                *index,
+                            guint64              *hash)
+{
+	Card *card;
+	gint64 due;
+
+	g_return_val_if_fail (self != NULL, FALSE);
+
+	if (now >= self->window_end)
+		atsa_review_scheduler_refill (self, now);
+
+	if (!atsa_due_queue_peek (self->queue, hash, &due) || due > now)
+		return FALSE;
+
+	card = g_hash_table_lookup (self->cards, hash);
+	*bank = card->bank;
+	*index = card->index;
+
+	return TRUE;
+}
+
+/* SM-2 by P. A. Wozniak, with failed questions relearned after a few
+ * minutes instead of the next day.
+ */
+static void
+sm2_update (AtsaReviewRecord *record,
+            AtsaReviewGrade   grade,
+            gint64            now)
+{
+	int q = grade;
+	double ease = record->ease / 1000.0;
+
+	ease += 0.1 - (5 - q) * (0.08 + (5 - q) * 0.02);
+	record->ease = (guint16) CLAMP ((int) (ease * 1000 + 0.5), MIN_EASE, G_MAXUINT16);
+
+	if (q < 3)
+	{
+		record->repetitions = 0;
+		record->interval = 0;
+		record->lapses = MIN (record->lapses + 1, G_MAXUINT16);
+		record->due = now + RELEARN_SECONDS;
+		return;
+	}
+
+	if (record->repetitions == 0)
+		record->interval = 1;
+	else if (record->repetitions == 1)
+		record->interval = 6;
+	else
+		record->interval = (guint32) MIN (record->interval * ease + 0.5, 36500);
+
+	record->repetitions = MIN (record->repetitions + 1, G_MAXUINT16);
+	record->due = now + (gint64) record->interval * DAY_SECONDS;
+}
+
+/**
+ * atsa_review_scheduler_record:
+ * @self: a #AtsaReviewScheduler
+ * @hash: the question, as returned by atsa_review_scheduler_next()
+ * @grade: how well it was answered
+ * @now: the current time in seconds since the epoch
+ * @error: return location for a #GError
+ *
+ * Schedules the next review of @hash according to @grade and saves it.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+atsa_review_scheduler_record (AtsaReviewScheduler  *self,
+                              guint64               hash,
+                              AtsaReviewGrade       grade,
+                              gint64                now,
+                              GError              **error)
+{
+	AtsaReviewRecord record;
+
+	g_return_val_if_fail (self != NULL, FALSE);
+	g_return_val_if_fail (hash != 0, FALSE);
+
+	if (!atsa_review_store_lookup (self->store, hash, &record))
+	{
+		memset (&record, 0, sizeof record);
+		record.hash = hash;
+		record.ease = DEFAULT_EASE;
+	}
+
+	sm2_update (&record, grade, now);
+
+	if (!atsa_review_store_put (self->store, &record, error))
+		return FALSE;
+
+	if (record.due < self->window_end)
+		atsa_due_queue_set (self->queue, hash, record.due);
+	else
+		atsa_due_queue_remove (self->queue, hash);
+
+	return TRUE;
+}
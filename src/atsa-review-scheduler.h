@@ -0,0 +1,59 @@
+/* atsa-review-scheduler.h
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#include "atsa-question-bank.h"
+#include "atsa-review-store.h"
+
+G_BEGIN_DECLS
+
+/* SM-2 response quality, 0 (blackout) to 5 (perfect) */
+typedef enum
+{
+	ATSA_REVIEW_GRADE_AGAIN = 1,
+	ATSA_REVIEW_GRADE_HARD  = 3,
+	ATSA_REVIEW_GRADE_GOOD  = 4,
+	ATSA_REVIEW_GRADE_EASY  = 5,
+} AtsaReviewGrade;
+
+typedef struct _AtsaReviewScheduler AtsaReviewScheduler;
+
+AtsaReviewScheduler *atsa_review_scheduler_new      (AtsaReviewStore      *store);
+void                 atsa_review_scheduler_free     (AtsaReviewScheduler  *self);
+void                 atsa_review_scheduler_add_bank (AtsaReviewScheduler  *self,
+                                                     AtsaQuestionBank     *bank,
+                                                     gint64                now);
+gboolean             atsa_review_scheduler_next     (AtsaReviewScheduler  *self,
+                                                     gint64                now,
+                                                     AtsaQuestionBank    **bank,
+                                                     guint                *index,
+                                                     guint64              *hash);
+gboolean             atsa_review_scheduler_record   (AtsaReviewScheduler  *self,
+                                                     guint64               hash,
+                                                     AtsaReviewGrade       grade,
+                                                     gint64                now,
+                                                     GError              **error);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (AtsaReviewScheduler, atsa_review_scheduler_free)
+
+G_END_DECLS
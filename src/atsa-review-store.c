@@ -0,0 +1,575 @@
+/* atsa-review-store.c
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+
+#include "atsa-review-store.h"
+
+/* Review state for every question ever studied, in one memory mapped file.
+ *
+ * The file is a 32 byte header followed by an open addressing hash table of
+ * fixed size records, indexed by question content hash with linear probing.
+ * Looking up or updating a question touches one or two pages no matter how
+ * many records there are, and nothing is read into memory up front: the
+ * kernel only pages in the slots that are actually probed. The table is
+ * doubled into a new file and renamed over the old one once it gets 70%
+ * full. That rehashes every record, so it runs on a worker thread: the
+ * mapped table is only read meanwhile and changes collect in memory until
+ * the next put after the worker is done swaps in the new table and writes
+ * them. Records are stored in host byte order, the file is not meant to be
+ * moved between machines.
+ */
+
+#define STORE_MAGIC       "ATSAREV1"
+#define INITIAL_CAPACITY  1024
+#define MAX_LOAD_PERCENT  70
+/* Returned by find_slot() when every slot is taken by another question */
+#define NO_SLOT           G_MAXUINT64
+
+typedef struct
+{
+	char    magic[8];
+	/* Number of slots, always a power of two */
+	guint64 capacity;
+	guint64 n_records;
+	guint64 reserved;
+} StoreHeader;
+
+G_STATIC_ASSERT (sizeof (StoreHeader) == 32);
+
+struct _AtsaReviewStore
+{
+	char             *path;
+	int               fd;
+	gsize             map_size;
+	StoreHeader      *header;
+	AtsaReviewRecord *records;
+
+	/* hash → AtsaReviewRecord not yet in the table */
+	GHashTable       *pending;
+	/* Pending records for questions that are not in the table either */
+	guint64           n_pending_new;
+
+	GThread          *grow_thread;
+	gint              grow_done;
+	AtsaReviewStore  *grown;
+	GError           *grow_error;
+};
+
+static gsize
+store_file_size (guint64 capacity)
+{
+	return sizeof (StoreHeader) + capacity * sizeof (AtsaReviewRecord);
+}
+
+static void
+set_error_from_errno (GError     **error,
+                      const char  *message,
+                      const char  *path)
+{
+	int errsv = errno;
+
+	g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+	             "%s “%s”: %s", message, path, g_strerror (errsv));
+}
+
+/* Returns the slot holding @hash, or the empty slot it would go into.
+ * The load limit keeps empty slots around, but a damaged file may not
+ * have any, so this gives up after looking at every slot once.
+ */
+static guint64
+find_slot (AtsaReviewRecord *records,
+           guint64           capacity,
+           guint64           hash)
+{
+	guint64 mask = capacity - 1;
+	guint64 slot = hash & mask;
+
+	for (guint64 i = 0; i < capacity; i++)
+	{
+		if (records[slot].hash == 0 || records[slot].hash == hash)
+			return slot;
+
+		slot = (slot + 1) & mask;
+	}
+
+	return NO_SLOT;
+}
+
+static void
+set_full_error (AtsaReviewStore  *self,
+                GError          **error)
+{
+	g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+	             _("“%s” is damaged, it has no room for more records"), self->path);
+}
+
+static gboolean
+store_map (AtsaReviewStore  *self,
+           GError          **error)
+{
+	struct stat st;
+	void *map;
+
+	if (fstat (self->fd, &st) != 0)
+	{
+		set_error_from_errno (error, _("Failed to read"), self->path);
+		return FALSE;
+	}
+
+	if (st.st_size == 0)
+	{
+		StoreHeader header = { .capacity = INITIAL_CAPACITY };
+
+		memcpy (header.magic, STORE_MAGIC, sizeof header.magic);
+
+		/* The records are left to be zero filled by the file system */
+		if (ftruncate (self->fd, store_file_size (INITIAL_CAPACITY)) != 0 ||
+		    pwrite (self->fd, &header, sizeof header, 0) != sizeof header)
+		{
+			set_error_from_errno (error, _("Failed to create"), self->path);
+			return FALSE;
+		}
+
+		st.st_size = store_file_size (INITIAL_CAPACITY);
+	}
+
+	if ((gsize) st.st_size < store_file_size (INITIAL_CAPACITY))
+	{
+		g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+		             _("“%s” is not a review state file"), self->path);
+		return FALSE;
+	}
+
+	map = mmap (NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, self->fd, 0);
+	if (map == MAP_FAILED)
+	{
+		set_error_from_errno (error, _("Failed to map"), self->path);
+		return FALSE;
+	}
+
+	self->map_size = st.st_size;
+	self->header = map;
+	self->records = (AtsaReviewRecord *) (self->header + 1);
+
+	if (memcmp (self->header->magic, STORE_MAGIC, sizeof self->header->magic) != 0 ||
+	    self->header->capacity == 0 ||
+	    (self->header->capacity & (self->header->capacity - 1)) != 0 ||
+	    store_file_size (self->header->capacity) != (gsize) st.st_size ||
+	    self->header->n_records * 100 > self->header->capacity * MAX_LOAD_PERCENT)
+	{
+		g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+		             _("“%s” is not a review state file"), self->path);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+store_unmap (AtsaReviewStore *self)
+{
+	if (self->header != NULL)
+	{
+		msync (self->header, self->map_size, MS_SYNC);
+		munmap (self->header, self->map_size);
+	}
+
+	self->header = NULL;
+	self->records = NULL;
+	self->map_size = 0;
+}
+
+static AtsaReviewStore *
+store_open_file (const char  *path,
+                 int          flags,
+                 GError     **error)
+{
+	AtsaReviewStore *self = g_new0 (AtsaReviewStore, 1);
+
+	self->path = g_strdup (path);
+	self->fd = g_open (path, O_RDWR | O_CREAT | O_CLOEXEC | flags, 0644);
+
+	if (self->fd < 0)
+	{
+		set_error_from_errno (error, _("Failed to open"), path);
+		atsa_review_store_close (self);
+		return NULL;
+	}
+
+	if (!store_map (self, error))
+	{
+		atsa_review_store_close (self);
+		return NULL;
+	}
+
+	return self;
+}
+
+/* Rehashes every record into a new file with a table twice the size and
+ * renames it over the old one.
+ */
+static AtsaReviewStore *
+store_grow (AtsaReviewStore  *self,
+            GError          **error)
+{
+	g_autofree char *tmp_path = g_strconcat (self->path, ".tmp", NULL);
+	AtsaReviewStore *grown;
+	guint64 capacity = self->header->capacity * 2;
+
+	g_unlink (tmp_path);
+	grown = store_open_file (tmp_path, O_EXCL, error);
+	if (grown == NULL)
+		return NULL;
+
+	store_unmap (grown);
+	if (ftruncate (grown->fd, store_file_size (capacity)) != 0)
+	{
+		set_error_from_errno (error, _("Failed to resize"), tmp_path);
+		goto fail;
+	}
+
+	grown->map_size = store_file_size (capacity);
+	grown->header = mmap (NULL, grown->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, grown->fd, 0);
+	if (grown->header == MAP_FAILED)
+	{
+		grown->header = NULL;
+		set_error_from_errno (error, _("Failed to map"), tmp_path);
+		goto fail;
+	}
+
+	grown->records = (AtsaReviewRecord *) (grown->header + 1);
+	grown->header->capacity = capacity;
+	grown->header->n_records = self->header->n_records;
+
+	for (guint64 i = 0; i < self->header->capacity; i++)
+	{
+		guint64 slot;
+
+		if (self->records[i].hash == 0)
+			continue;
+
+		/* Twice the slots, so there is always room */
+		slot = find_slot (grown->records, capacity, self->records[i].hash);
+		grown->records[slot] = self->records[i];
+	}
+
+	/* Flush before the rename, a crash must leave either the old or the
+	 * complete new table behind.
+	 */
+	if (msync (grown->header, grown->map_size, MS_SYNC) != 0 ||
+	    g_rename (tmp_path, self->path) != 0)
+	{
+		set_error_from_errno (error, _("Failed to write"), tmp_path);
+		goto fail;
+	}
+
+	return grown;
+
+fail:
+	atsa_review_store_close (grown);
+	g_unlink (tmp_path);
+	return NULL;
+}
+
+static gpointer
+store_grow_thread (gpointer data)
+{
+	AtsaReviewStore *self = data;
+
+	self->grown = store_grow (self, &self->grow_error);
+	g_atomic_int_set (&self->grow_done, TRUE);
+
+	return NULL;
+}
+
+static gboolean
+store_start_grow (AtsaReviewStore  *self,
+                  GError          **error)
+{
+	self->grow_thread = g_thread_try_new ("atsa-review-store", store_grow_thread, self, error);
+
+	return self->grow_thread != NULL;
+}
+
+/* Writes the pending records that fit without going over the load limit */
+static void
+store_apply_pending (AtsaReviewStore *self)
+{
+	GHashTableIter iter;
+	AtsaReviewRecord *record;
+
+	g_hash_table_iter_init (&iter, self->pending);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &record))
+	{
+		guint64 slot = find_slot (self->records, self->header->capacity, record->hash);
+
+		if (slot == NO_SLOT)
+			continue;
+
+		if (self->records[slot].hash == 0)
+		{
+			if ((self->header->n_records + 1) * 100 > self->header->capacity * MAX_LOAD_PERCENT)
+				continue;
+
+			self->header->n_records++;
+			self->n_pending_new--;
+		}
+
+		self->records[slot] = *record;
+		g_hash_table_iter_remove (&iter);
+	}
+}
+
+/* Swaps in the table doubled by the worker, waiting for it if @wait is
+ * set and doing nothing while it still runs otherwise. If growing failed
+ * the changes are kept pending and it is tried again on the next put.
+ */
+static gboolean
+store_finish_grow (AtsaReviewStore  *self,
+                   gboolean          wait,
+                   GError          **error)
+{
+	AtsaReviewStore *grown;
+
+	if (self->grow_thread == NULL)
+		return TRUE;
+
+	if (!wait && !g_atomic_int_get (&self->grow_done))
+		return TRUE;
+
+	g_thread_join (g_steal_pointer (&self->grow_thread));
+	self->grow_done = FALSE;
+
+	grown = g_steal_pointer (&self->grown);
+	if (grown == NULL)
+	{
+		g_propagate_error (error, g_steal_pointer (&self->grow_error));
+		return FALSE;
+	}
+
+	/* The file has been replaced, nothing to flush */
+	munmap (self->header, self->map_size);
+	close (self->fd);
+
+	self->fd = grown->fd;
+	self->map_size = grown->map_size;
+	self->header = grown->header;
+	self->records = grown->records;
+
+	g_free (grown->path);
+	g_free (grown);
+
+	store_apply_pending (self);
+
+	return TRUE;
+}
+
+static void
+store_put_pending (AtsaReviewStore        *self,
+                   const AtsaReviewRecord *record)
+{
+	AtsaReviewRecord *copy;
+	guint64 slot;
+
+	if (!g_hash_table_contains (self->pending, &record->hash))
+	{
+		slot = find_slot (self->records, self->header->capacity, record->hash);
+		if (slot == NO_SLOT || self->records[slot].hash == 0)
+			self->n_pending_new++;
+	}
+
+	copy = g_memdup2 (record, sizeof *record);
+	g_hash_table_replace (self->pending, &copy->hash, copy);
+}
+
+/**
+ * atsa_review_store_open:
+ * @path: path of the review state file, created if missing
+ * @error: return location for a #GError
+ *
+ * Returns: (transfer full): the store, or %NULL on error
+ */
+AtsaReviewStore *
+atsa_review_store_open (const char  *path,
+                        GError     **error)
+{
+	g_autofree char *dir = NULL;
+	AtsaReviewStore *self;
+
+	g_return_val_if_fail (path != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	dir = g_path_get_dirname (path);
+	if (g_mkdir_with_parents (dir, 0755) != 0)
+	{
+		set_error_from_errno (error, _("Failed to create"), dir);
+		return NULL;
+	}
+
+	self = store_open_file (path, 0, error);
+	if (self != NULL)
+		self->pending = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL, g_free);
+
+	return self;
+}
+
+/**
+ * atsa_review_store_close:
+ * @self: a #AtsaReviewStore
+ *
+ * Writes outstanding changes to disk and frees @self. Waits for the table
+ * to finish growing if it is.
+ */
+void
+atsa_review_store_close (AtsaReviewStore *self)
+{
+	if (self == NULL)
+		return;
+
+	while (self->grow_thread != NULL ||
+	       (self->pending != NULL && g_hash_table_size (self->pending) > 0))
+	{
+		g_autoptr(GError) error = NULL;
+
+		if (!store_finish_grow (self, TRUE, &error) ||
+		    (g_hash_table_size (self->pending) > 0 && !store_start_grow (self, &error)))
+		{
+			g_printerr ("Lost %u review records: %s\n",
+			            g_hash_table_size (self->pending), error->message);
+			break;
+		}
+	}
+
+	g_clear_pointer (&self->pending, g_hash_table_unref);
+	store_unmap (self);
+	if (self->fd >= 0)
+		close (self->fd);
+	g_free (self->path);
+	g_free (self);
+}
+
+gsize
+atsa_review_store_get_n_records (AtsaReviewStore *self)
+{
+	g_return_val_if_fail (self != NULL, 0);
+
+	return self->header->n_records + self->n_pending_new;
+}
+
+/**
+ * atsa_review_store_lookup:
+ * @self: a #AtsaReviewStore
+ * @hash: the content hash of a question
+ * @record: (out): return location for the record
+ *
+ * Returns: %TRUE if the question has been reviewed before
+ */
+gboolean
+atsa_review_store_lookup (AtsaReviewStore  *self,
+                          guint64           hash,
+                          AtsaReviewRecord *record)
+{
+	AtsaReviewRecord *pending;
+	guint64 slot;
+
+	g_return_val_if_fail (self != NULL, FALSE);
+	g_return_val_if_fail (hash != 0, FALSE);
+
+	pending = g_hash_table_lookup (self->pending, &hash);
+	if (pending != NULL)
+	{
+		*record = *pending;
+		return TRUE;
+	}
+
+	slot = find_slot (self->records, self->header->capacity, hash);
+	if (slot == NO_SLOT || self->records[slot].hash == 0)
+		return FALSE;
+
+	*record = self->records[slot];
+
+	return TRUE;
+}
+
+/**
+ * atsa_review_store_put:
+ * @self: a #AtsaReviewStore
+ * @record: the new state of a question
+ * @error: return location for a #GError
+ *
+ * Inserts or replaces the record for @record->hash. The change goes to
+ * the mapped file directly and reaches the disk with the kernel's normal
+ * write back, or at the latest when the store is closed. While the table
+ * grows it is kept in memory until the new table is ready.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+atsa_review_store_put (AtsaReviewStore         *self,
+                       const AtsaReviewRecord  *record,
+                       GError                 **error)
+{
+	guint64 slot;
+
+	g_return_val_if_fail (self != NULL, FALSE);
+	g_return_val_if_fail (record != NULL && record->hash != 0, FALSE);
+
+	if (!store_finish_grow (self, FALSE, error))
+		return FALSE;
+
+	if (self->grow_thread == NULL && g_hash_table_size (self->pending) == 0)
+	{
+		slot = find_slot (self->records, self->header->capacity, record->hash);
+		if (slot == NO_SLOT)
+		{
+			set_full_error (self, error);
+			return FALSE;
+		}
+
+		if (self->records[slot].hash != 0 ||
+		    (self->header->n_records + 1) * 100 <= self->header->capacity * MAX_LOAD_PERCENT)
+		{
+			if (self->records[slot].hash == 0)
+				self->header->n_records++;
+
+			self->records[slot] = *record;
+
+			return TRUE;
+		}
+	}
+
+	if (self->grow_thread == NULL && !store_start_grow (self, error))
+		return FALSE;
+
+	store_put_pending (self, record);
+
+	return TRUE;
+}
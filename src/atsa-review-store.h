@@ -0,0 +1,61 @@
+/* atsa-review-store.h
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Review state of one question, exactly as stored on disk */
+typedef struct
+{
+	/* atsa_question_content_hash(), 0 marks an empty slot */
+	guint64 hash;
+	/* When the question is next due, in seconds since the epoch */
+	gint64  due;
+	/* Current interval in days */
+	guint32 interval;
+	/* SM-2 ease factor × 1000 */
+	guint16 ease;
+	guint16 repetitions;
+	guint16 lapses;
+	guint16 reserved1;
+	guint32 reserved2;
+} AtsaReviewRecord;
+
+G_STATIC_ASSERT (sizeof (AtsaReviewRecord) == 32);
+
+typedef struct _AtsaReviewStore AtsaReviewStore;
+
+AtsaReviewStore *atsa_review_store_open          (const char              *path,
+                                                  GError                 **error);
+void             atsa_review_store_close         (AtsaReviewStore         *self);
+gsize            atsa_review_store_get_n_records (AtsaReviewStore         *self);
+gboolean         atsa_review_store_lookup        (AtsaReviewStore         *self,
+                                                  guint64                  hash,
+                                                  AtsaReviewRecord        *record);
+gboolean         atsa_review_store_put           (AtsaReviewStore         *self,
+                                                  const AtsaReviewRecord  *record,
+                                                  GError                 **error);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (AtsaReviewStore, atsa_review_store_close)
+
+G_END_DECLS
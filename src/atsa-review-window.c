@@ -0,0 +1,258 @@
+/* atsa-review-window.c
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include <glib/gi18n.h>
+
+#include "atsa-review-window.h"
+#include "atsa-rich-label.h"
+#include "atsa-rich-text.h"
+
+struct _AtsaReviewWindow
+{
+	AdwWindow            parent_instance;
+
+	/* Owned by the application, which outlives its windows */
+	AtsaReviewScheduler *scheduler;
+	guint64              current_hash;
+
+	AdwToastOverlay     *toast_overlay;
+	GtkStack            *stack;
+	AtsaRichLabel       *question_label;
+	AtsaRichLabel       *answer_label;
+	GtkWidget           *show_answer_button;
+	GtkWidget           *grade_box;
+};
+
+G_DEFINE_FINAL_TYPE (AtsaReviewWindow, atsa_review_window, ADW_TYPE_WINDOW)
+
+static gint64
+now_in_seconds (void)
+{
+	return g_get_real_time () / G_USEC_PER_SEC;
+}
+
+static char *
+format_answer (const AtsaQuestion *question)
+{
+	GString *markup = g_string_new (NULL);
+
+	if (question->type == QUESTION_TYPE_MULTIPLE_CHOICE)
+	{
+		if (question->correct_answer < g_strv_length (question->choices))
+		{
+			g_autofree char *choice = atsa_rich_text_to_markup (question->choices[question->correct_answer]);
+
+			g_string_append_printf (markup, "<b>%c.</b> %s",
+			                        'A' + (question->correct_answer % 26), choice);
+		}
+	}
+	else
+	{
+		for (guint i = 0; question->choices[i] != NULL; i++)
+		{
+			g_autofree char *answer = g_markup_escape_text (question->tf_answers[i] ? _("True") : _("False"), -1);
+
+			g_string_append_printf (markup, "%s%u) <b>%s</b>",
+			                        i > 0 ? "\n" : "", i + 1, answer);
+		}
+	}
+
+	return g_string_free (markup, FALSE);
+}
+
+static void
+atsa_review_window_show_next (AtsaReviewWindow *self)
+{
+	AtsaQuestionBank *bank;
+	const AtsaQuestion *question;
+	g_autofree char *question_text = NULL;
+	g_autofree char *answer_text = NULL;
+	guint index;
+
+	if (!atsa_review_scheduler_next (self->scheduler, now_in_seconds (),
+	                                 &bank, &index, &self->current_hash))
+	{
+		self->current_hash = 0;
+		gtk_stack_set_visible_child_name (self->stack, "done");
+		return;
+	}
+
+	question = atsa_question_bank_get_question (bank, index);
+	question_text = atsa_question_to_markup (question, 0, NULL, FALSE);
+	answer_text = format_answer (question);
+
+	atsa_rich_label_set_markup (self->question_label, question_text);
+	atsa_rich_label_set_markup (self->answer_label, answer_text);
+	gtk_widget_set_visible (GTK_WIDGET (self->answer_label), FALSE);
+	gtk_widget_set_visible (self->show_answer_button, TRUE);
+	gtk_widget_set_visible (self->grade_box, FALSE);
+	gtk_stack_set_visible_child_name (self->stack, "card");
+}
+
+static void
+show_answer_action (GtkWidget  *widget,
+                    const char *action_name,
+                    GVariant   *parameter)
+{
+	AtsaReviewWindow *self = ATSA_REVIEW_WINDOW (widget);
+
+	gtk_widget_set_visible (GTK_WIDGET (self->answer_label), TRUE);
+	gtk_widget_set_visible (self->show_answer_button, FALSE);
+	gtk_widget_set_visible (self->grade_box, TRUE);
+}
+
+static void
+grade_action (GtkWidget  *widget,
+              const char *action_name,
+              GVariant   *parameter)
+{
+	AtsaReviewWindow *self = ATSA_REVIEW_WINDOW (widget);
+	g_autoptr(GError) error = NULL;
+
+	if (self->current_hash == 0)
+		return;
+
+	if (!atsa_review_scheduler_record (self->scheduler,
+	                                   self->current_hash,
+	                                   g_variant_get_int32 (parameter),
+	                                   now_in_seconds (),
+	                                   &error))
+		adw_toast_overlay_add_toast (self->toast_overlay, adw_toast_new (error->message));
+
+	atsa_review_window_show_next (self);
+}
+
+static void
+refresh_action (GtkWidget  *widget,
+                const char *action_name,
+                GVariant   *parameter)
+{
+	atsa_review_window_show_next (ATSA_REVIEW_WINDOW (widget));
+}
+
+static GtkWidget *
+grade_button_new (const char      *label,
+                  AtsaReviewGrade  grade)
+{
+	GtkWidget *button = gtk_button_new_with_mnemonic (label);
+
+	gtk_actionable_set_action_name (GTK_ACTIONABLE (button), "review.grade");
+	gtk_actionable_set_action_target (GTK_ACTIONABLE (button), "i", (gint32) grade);
+	gtk_widget_add_css_class (button, "pill");
+
+	return button;
+}
+
+static void
+atsa_review_window_class_init (AtsaReviewWindowClass *klass)
+{
+	GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+	gtk_widget_class_install_action (widget_class, "review.show-answer", NULL, show_answer_action);
+	gtk_widget_class_install_action (widget_class, "review.grade", "i", grade_action);
+	gtk_widget_class_install_action (widget_class, "review.refresh", NULL, refresh_action);
+}
+
+static void
+atsa_review_window_init (AtsaReviewWindow *self)
+{
+	GtkWidget *toolbar_view;
+	GtkWidget *scrolled_window;
+	GtkWidget *card;
+	GtkWidget *status_page;
+	GtkWidget *button;
+
+	gtk_window_set_default_size (GTK_WINDOW (self), 640, 560);
+	gtk_window_set_title (GTK_WINDOW (self), _("Review"));
+
+	self->question_label = ATSA_RICH_LABEL (atsa_rich_label_new (NULL));
+	self->answer_label = ATSA_RICH_LABEL (atsa_rich_label_new (NULL));
+
+	self->show_answer_button = gtk_button_new_with_mnemonic (_("_Show Answer"));
+	gtk_actionable_set_action_name (GTK_ACTIONABLE (self->show_answer_button), "review.show-answer");
+	gtk_widget_set_halign (self->show_answer_button, GTK_ALIGN_CENTER);
+	gtk_widget_add_css_class (self->show_answer_button, "pill");
+	gtk_widget_add_css_class (self->show_answer_button, "suggested-action");
+
+	self->grade_box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 12);
+	gtk_widget_set_halign (self->grade_box, GTK_ALIGN_CENTER);
+	gtk_box_append (GTK_BOX (self->grade_box), grade_button_new (_("_Again"), ATSA_REVIEW_GRADE_AGAIN));
+	gtk_box_append (GTK_BOX (self->grade_box), grade_button_new (_("_Hard"), ATSA_REVIEW_GRADE_HARD));
+	gtk_box_append (GTK_BOX (self->grade_box), grade_button_new (_("_Good"), ATSA_REVIEW_GRADE_GOOD));
+	gtk_box_append (GTK_BOX (self->grade_box), grade_button_new (_("_Easy"), ATSA_REVIEW_GRADE_EASY));
+
+	card = gtk_box_new (GTK_ORIENTATION_VERTICAL, 24);
+	gtk_widget_set_margin_top (card, 24);
+	gtk_widget_set_margin_bottom (card, 24);
+	gtk_widget_set_margin_start (card, 24);
+	gtk_widget_set_margin_end (card, 24);
+	gtk_box_append (GTK_BOX (card), GTK_WIDGET (self->question_label));
+	gtk_box_append (GTK_BOX (card), GTK_WIDGET (self->answer_label));
+	gtk_box_append (GTK_BOX (card), self->show_answer_button);
+	gtk_box_append (GTK_BOX (card), self->grade_box);
+
+	scrolled_window = gtk_scrolled_window_new ();
+	gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled_window),
+	                                GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+	gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (scrolled_window), card);
+
+	button = gtk_button_new_with_mnemonic (_("_Check Again"));
+	gtk_actionable_set_action_name (GTK_ACTIONABLE (button), "review.refresh");
+	gtk_widget_set_halign (button, GTK_ALIGN_CENTER);
+	gtk_widget_add_css_class (button, "pill");
+
+	status_page = adw_status_page_new ();
+	adw_status_page_set_icon_name (ADW_STATUS_PAGE (status_page), "emblem-ok-symbolic");
+	adw_status_page_set_title (ADW_STATUS_PAGE (status_page), _("All Caught Up"));
+	adw_status_page_set_description (ADW_STATUS_PAGE (status_page),
+	                                 _("No questions are due. Open a question file to study its questions."));
+	adw_status_page_set_child (ADW_STATUS_PAGE (status_page), button);
+
+	self->stack = GTK_STACK (gtk_stack_new ());
+	gtk_stack_add_named (self->stack, scrolled_window, "card");
+	gtk_stack_add_named (self->stack, status_page, "done");
+
+	self->toast_overlay = ADW_TOAST_OVERLAY (adw_toast_overlay_new ());
+	adw_toast_overlay_set_child (self->toast_overlay, GTK_WIDGET (self->stack));
+
+	toolbar_view = adw_toolbar_view_new ();
+	adw_toolbar_view_add_top_bar (ADW_TOOLBAR_VIEW (toolbar_view), adw_header_bar_new ());
+	adw_toolbar_view_set_content (ADW_TOOLBAR_VIEW (toolbar_view), GTK_WIDGET (self->toast_overlay));
+	adw_window_set_content (ADW_WINDOW (self), toolbar_view);
+}
+
+AtsaReviewWindow *
+atsa_review_window_new (GtkApplication      *app,
+                        AtsaReviewScheduler *scheduler)
+{
+	AtsaReviewWindow *self;
+
+	g_return_val_if_fail (scheduler != NULL, NULL);
+
+	self = g_object_new (ATSA_TYPE_REVIEW_WINDOW,
+	                     "application", app,
+	                     NULL);
+	self->scheduler = scheduler;
+	atsa_review_window_show_next (self);
+
+	return self;
+}
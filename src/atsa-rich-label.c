@@ -0,0 +1,332 @@
+/* atsa-rich-label.c
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include "atsa-rich-label.h"
+#include "atsa-rich-text.h"
+
+/* A label for question markup that never lays out text itself.
+ *
+ * Sizes and pixels come from the shared AtsaRichTextCache; until a rendering
+ * for the current width is ready the label keeps its previous height so rows
+ * don't jump around while scrolling, and redraws once the worker is done.
+ */
+
+#define NATURAL_WIDTH 480
+
+struct _AtsaRichLabel
+{
+	GtkWidget  parent_instance;
+
+	char      *markup;
+	/* Height of the last rendering, used while a new one is in flight */
+	int        last_height;
+	guint      waiting : 1;
+};
+
+G_DEFINE_FINAL_TYPE (AtsaRichLabel, atsa_rich_label, GTK_TYPE_WIDGET)
+
+enum {
+	PROP_0,
+	PROP_MARKUP,
+	N_PROPS
+};
+
+static GParamSpec *properties [N_PROPS];
+
+static gboolean
+atsa_rich_label_lookup (AtsaRichLabel  *self,
+                        int             width,
+                        GdkTexture    **texture,
+                        int            *height)
+{
+	if (self->markup == NULL || self->markup[0] == '\0')
+		return FALSE;
+
+	/* The context carries the font, the text scaling and hinting settings */
+	if (atsa_rich_text_cache_lookup (atsa_rich_text_cache_get_default (),
+	                                 self->markup,
+	                                 gtk_widget_get_pango_context (GTK_WIDGET (self)),
+	                                 width,
+	                                 gtk_widget_get_scale_factor (GTK_WIDGET (self)),
+	                                 texture, height))
+		return TRUE;
+
+	self->waiting = TRUE;
+
+	return FALSE;
+}
+
+static int
+atsa_rich_label_estimate_height (AtsaRichLabel *self)
+{
+	PangoContext *context;
+	PangoFontMetrics *metrics;
+	int height;
+
+	if (self->last_height > 0)
+		return self->last_height;
+
+	context = gtk_widget_get_pango_context (GTK_WIDGET (self));
+	metrics = pango_context_get_metrics (context, NULL, NULL);
+	height = PANGO_PIXELS_CEIL (pango_font_metrics_get_height (metrics));
+	pango_font_metrics_unref (metrics);
+
+	return height;
+}
+
+static void
+rendered_cb (AtsaRichTextCache *cache,
+             const char        *markup,
+             AtsaRichLabel     *self)
+{
+	if (!self->waiting || g_strcmp0 (markup, self->markup) != 0)
+		return;
+
+	self->waiting = FALSE;
+	gtk_widget_queue_resize (GTK_WIDGET (self));
+}
+
+static GtkSizeRequestMode
+atsa_rich_label_get_request_mode (GtkWidget *widget)
+{
+	return GTK_SIZE_REQUEST_HEIGHT_FOR_WIDTH;
+}
+
+static void
+atsa_rich_label_measure (GtkWidget      *widget,
+                         GtkOrientation  orientation,
+                         int             for_size,
+                         int            *minimum,
+                         int            *natural,
+                         int            *minimum_baseline,
+                         int            *natural_baseline)
+{
+	AtsaRichLabel *self = ATSA_RICH_LABEL (widget);
+	int height;
+
+	if (orientation == GTK_ORIENTATION_HORIZONTAL)
+	{
+		/* Wraps to whatever it is given, containers decide the width */
+		*minimum = 0;
+		*natural = NATURAL_WIDTH;
+		return;
+	}
+
+	if (self->markup == NULL || self->markup[0] == '\0')
+		height = 0;
+	else if (for_size > 0 && atsa_rich_label_lookup (self, for_size, NULL, &height))
+		self->last_height = height;
+	else
+		height = atsa_rich_label_estimate_height (self);
+
+	*minimum = *natural = height;
+}
+
+static void
+atsa_rich_label_snapshot (GtkWidget   *widget,
+                          GtkSnapshot *snapshot)
+{
+	AtsaRichLabel *self = ATSA_RICH_LABEL (widget);
+	int width = gtk_widget_get_width (widget);
+	GdkTexture *texture;
+	int height;
+	GdkRGBA color;
+	graphene_matrix_t matrix;
+	graphene_vec4_t offset;
+
+	if (!atsa_rich_label_lookup (self, width, &texture, &height))
+		return;
+
+	gtk_widget_get_color (widget, &color);
+
+	/* Too large to render off-screen, lay it out here instead */
+	if (texture == NULL)
+	{
+		g_autoptr(PangoLayout) layout = gtk_widget_create_pango_layout (widget, NULL);
+
+		pango_layout_set_width (layout, width * PANGO_SCALE);
+		pango_layout_set_wrap (layout, PANGO_WRAP_WORD_CHAR);
+		pango_layout_set_markup (layout, self->markup, -1);
+		gtk_snapshot_append_layout (snapshot, layout, &color);
+		return;
+	}
+
+	/* The cached texture is white, map it to the current foreground colour */
+	graphene_matrix_init_from_float (&matrix, (float[16]) {
+	                                   0, 0, 0, 0,
+	                                   0, 0, 0, 0,
+	                                   0, 0, 0, 0,
+	                                   0, 0, 0, color.alpha });
+	graphene_vec4_init (&offset, color.red, color.green, color.blue, 0);
+
+	gtk_snapshot_push_color_matrix (snapshot, &matrix, &offset);
+	gtk_snapshot_append_texture (snapshot, texture, &GRAPHENE_RECT_INIT (0, 0, width, height));
+	gtk_snapshot_pop (snapshot);
+}
+
+static void
+atsa_rich_label_finalize (GObject *object)
+{
+	AtsaRichLabel *self = ATSA_RICH_LABEL (object);
+
+	g_clear_pointer (&self->markup, g_free);
+
+	G_OBJECT_CLASS (atsa_rich_label_parent_class)->finalize (object);
+}
+
+static void
+atsa_rich_label_get_property (GObject    *object,
+                              guint       prop_id,
+                              GValue     *value,
+                              GParamSpec *pspec)
+{
+	AtsaRichLabel *self = ATSA_RICH_LABEL (object);
+
+	switch (prop_id)
+	{
+	case PROP_MARKUP:
+		g_value_set_string (value, self->markup);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+	}
+}
+
+static void
+atsa_rich_label_set_property (GObject      *object,
+                              guint         prop_id,
+                              const GValue *value,
+                              GParamSpec   *pspec)
+{
+	AtsaRichLabel *self = ATSA_RICH_LABEL (object);
+
+	switch (prop_id)
+	{
+	case PROP_MARKUP:
+		atsa_rich_label_set_markup (self, g_value_get_string (value));
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+	}
+}
+
+static void
+atsa_rich_label_class_init (AtsaRichLabelClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+	object_class->finalize = atsa_rich_label_finalize;
+	object_class->get_property = atsa_rich_label_get_property;
+	object_class->set_property = atsa_rich_label_set_property;
+
+	widget_class->get_request_mode = atsa_rich_label_get_request_mode;
+	widget_class->measure = atsa_rich_label_measure;
+	widget_class->snapshot = atsa_rich_label_snapshot;
+
+	properties [PROP_MARKUP] =
+		g_param_spec_string ("markup", NULL, NULL,
+		                     NULL,
+		                     (G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_properties (object_class, N_PROPS, properties);
+
+	gtk_widget_class_set_css_name (widget_class, "label");
+	gtk_widget_class_set_accessible_role (widget_class, GTK_ACCESSIBLE_ROLE_LABEL);
+}
+
+static void
+atsa_rich_label_init (AtsaRichLabel *self)
+{
+	g_signal_connect_object (atsa_rich_text_cache_get_default (),
+	                         "rendered",
+	                         G_CALLBACK (rendered_cb),
+	                         self,
+	                         0);
+}
+
+GtkWidget *
+atsa_rich_label_new (const char *markup)
+{
+	return g_object_new (ATSA_TYPE_RICH_LABEL,
+	                     "markup", markup,
+	                     NULL);
+}
+
+const char *
+atsa_rich_label_get_markup (AtsaRichLabel *self)
+{
+	g_return_val_if_fail (ATSA_IS_RICH_LABEL (self), NULL);
+
+	return self->markup;
+}
+
+/**
+ * atsa_rich_label_set_markup:
+ * @self: a #AtsaRichLabel
+ * @markup: (nullable): Pango markup, such as from atsa_question_to_markup()
+ *
+ * Parses @markup on the calling thread for the accessible label. Lists
+ * that rebind rows while scrolling should prepare the plain text up front
+ * and use atsa_rich_label_set_markup_with_text() instead.
+ */
+void
+atsa_rich_label_set_markup (AtsaRichLabel *self,
+                            const char    *markup)
+{
+	g_autofree char *text = NULL;
+
+	g_return_if_fail (ATSA_IS_RICH_LABEL (self));
+
+	if (markup != NULL && g_strcmp0 (markup, self->markup) != 0)
+		pango_parse_markup (markup, -1, 0, NULL, &text, NULL, NULL);
+
+	atsa_rich_label_set_markup_with_text (self, markup, text);
+}
+
+/**
+ * atsa_rich_label_set_markup_with_text:
+ * @self: a #AtsaRichLabel
+ * @markup: (nullable): Pango markup
+ * @text: (nullable): @markup without its tags, for assistive technologies
+ */
+void
+atsa_rich_label_set_markup_with_text (AtsaRichLabel *self,
+                                      const char    *markup,
+                                      const char    *text)
+{
+	g_return_if_fail (ATSA_IS_RICH_LABEL (self));
+
+	if (!g_set_str (&self->markup, markup))
+		return;
+
+	/* Rows get recycled with unrelated text, start over with the estimate */
+	self->last_height = 0;
+	self->waiting = FALSE;
+
+	gtk_accessible_update_property (GTK_ACCESSIBLE (self),
+	                                GTK_ACCESSIBLE_PROPERTY_LABEL, text,
+	                                -1);
+
+	gtk_widget_queue_resize (GTK_WIDGET (self));
+	g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_MARKUP]);
+}
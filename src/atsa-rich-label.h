@@ -0,0 +1,39 @@
+/* atsa-rich-label.h
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define ATSA_TYPE_RICH_LABEL (atsa_rich_label_get_type())
+
+G_DECLARE_FINAL_TYPE (AtsaRichLabel, atsa_rich_label, ATSA, RICH_LABEL, GtkWidget)
+
+GtkWidget  *atsa_rich_label_new                  (const char    *markup);
+const char *atsa_rich_label_get_markup           (AtsaRichLabel *self);
+void        atsa_rich_label_set_markup           (AtsaRichLabel *self,
+                                                  const char    *markup);
+void        atsa_rich_label_set_markup_with_text (AtsaRichLabel *self,
+                                                  const char    *markup,
+                                                  const char    *text);
+
+G_END_DECLS
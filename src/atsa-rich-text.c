@@ -0,0 +1,902 @@
+/* atsa-rich-text.c
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include "atsa-rich-text.h"
+
+/* Question files use a small inline syntax on top of plain text:
+ *
+ *   **bold**  *italic*  `code`  $math$
+ *
+ * Inside $…$ a TeX-like subset is understood: ^ and _ for super- and
+ * subscripts, {…} for grouping, \frac{a}{b}, \sqrt{x} and the usual
+ * \alpha, \times, \leq… symbols. Each field of a question is translated
+ * to Pango markup on its own, see atsa_question_to_markup(), and the joined
+ * markup is what both the on-screen labels and the printed pages lay out.
+ *
+ * Turning that into pixels is far too slow to repeat on every frame, so
+ * AtsaRichTextCache does the layout on worker threads and keeps the
+ * resulting textures in a byte-bounded LRU keyed by markup and everything
+ * about the widget's Pango context that changes the pixels: font,
+ * resolution (which follows the text scaling setting) and font options.
+ * Only one width is kept per key. Asking for another width, as happens for
+ * every step of a window resize, replaces the rendering and cancels one
+ * still in flight, so stale widths neither pile up in the cache nor keep
+ * the workers busy.
+ */
+
+#define DEFAULT_CACHE_BYTES (64 * 1024 * 1024)
+/* Cairo refuses to create larger image surfaces */
+#define MAX_SURFACE_SIZE    32767
+
+static const struct {
+	const char *name;
+	const char *symbol;
+} math_symbols[] = {
+	{ "alpha", "α" }, { "beta", "β" }, { "gamma", "γ" }, { "delta", "δ" },
+	{ "epsilon", "ε" }, { "zeta", "ζ" }, { "eta", "η" }, { "theta", "θ" },
+	{ "iota", "ι" }, { "kappa", "κ" }, { "lambda", "λ" }, { "mu", "μ" },
+	{ "nu", "ν" }, { "xi", "ξ" }, { "pi", "π" }, { "rho", "ρ" },
+	{ "sigma", "σ" }, { "tau", "τ" }, { "upsilon", "υ" }, { "phi", "φ" },
+	{ "chi", "χ" }, { "psi", "ψ" }, { "omega", "ω" },
+	{ "Gamma", "Γ" }, { "Delta", "Δ" }, { "Theta", "Θ" }, { "Lambda", "Λ" },
+	{ "Xi", "Ξ" }, { "Pi", "Π" }, { "Sigma", "Σ" }, { "Phi", "Φ" },
+	{ "Psi", "Ψ" }, { "Omega", "Ω" },
+	{ "times", "×" }, { "cdot", "·" }, { "div", "÷" }, { "pm", "±" },
+	{ "mp", "∓" }, { "leq", "≤" }, { "le", "≤" }, { "geq", "≥" },
+	{ "ge", "≥" }, { "neq", "≠" }, { "ne", "≠" }, { "approx", "≈" },
+	{ "equiv", "≡" }, { "infty", "∞" }, { "partial", "∂" }, { "nabla", "∇" },
+	{ "sum", "∑" }, { "prod", "∏" }, { "int", "∫" }, { "in", "∈" },
+	{ "notin", "∉" }, { "subset", "⊂" }, { "subseteq", "⊆" }, { "cup", "∪" },
+	{ "cap", "∩" }, { "emptyset", "∅" }, { "forall", "∀" }, { "exists", "∃" },
+	{ "neg", "¬" }, { "wedge", "∧" }, { "vee", "∨" }, { "to", "→" },
+	{ "rightarrow", "→" }, { "leftarrow", "←" }, { "Rightarrow", "⇒" },
+	{ "Leftrightarrow", "⇔" }, { "degree", "°" }, { "ldots", "…" },
+	{ "cdots", "⋯" },
+};
+
+static void
+append_escaped (GString    *out,
+                const char *p,
+                gsize       len)
+{
+	for (gsize i = 0; i < len; i++)
+	{
+		switch (p[i])
+		{
+		case '<':  g_string_append (out, "&lt;"); break;
+		case '>':  g_string_append (out, "&gt;"); break;
+		case '&':  g_string_append (out, "&amp;"); break;
+		case '\'': g_string_append (out, "&apos;"); break;
+		case '"':  g_string_append (out, "&quot;"); break;
+		default:   g_string_append_c (out, p[i]); break;
+		}
+	}
+}
+
+/* Groups and arguments nested deeper than this are shown verbatim, so a
+ * malformed file can't exhaust the stack.
+ */
+#define MAX_MATH_DEPTH 32
+
+static void math_run     (GString *out, const char **p, const char *end, guint depth, gboolean in_group);
+static void math_command (GString *out, const char **p, const char *end, guint depth);
+
+static gboolean
+math_too_deep (GString     *out,
+               const char **p,
+               const char  *end,
+               guint        depth)
+{
+	if (depth <= MAX_MATH_DEPTH)
+		return FALSE;
+
+	/* Every enclosing level sees the end and closes its tags */
+	append_escaped (out, *p, end - *p);
+	*p = end;
+
+	return TRUE;
+}
+
+/* Parses a single argument of ^, _, \frac or \sqrt: either a {group}, a
+ * \command or one character.
+ */
+static void
+math_atom (GString     *out,
+           const char **p,
+           const char  *end,
+           guint        depth)
+{
+	const char *start;
+
+	if (math_too_deep (out, p, end, depth))
+		return;
+
+	while (*p < end && **p == ' ')
+		(*p)++;
+
+	if (*p >= end)
+		return;
+
+	if (**p == '{')
+	{
+		(*p)++;
+		math_run (out, p, end, depth + 1, TRUE);
+		return;
+	}
+
+	if (**p == '\\')
+	{
+		(*p)++;
+		math_command (out, p, end, depth);
+		return;
+	}
+
+	start = *p;
+	*p = g_utf8_next_char (*p);
+	if (g_ascii_isalpha (*start))
+	{
+		g_string_append (out, "<i>");
+		append_escaped (out, start, *p - start);
+		g_string_append (out, "</i>");
+	}
+	else
+		append_escaped (out, start, *p - start);
+}
+
+static void
+math_command (GString     *out,
+              const char **p,
+              const char  *end,
+              guint        depth)
+{
+	const char *name = *p;
+	gsize len;
+
+	while (*p < end && g_ascii_isalpha (**p))
+		(*p)++;
+	len = *p - name;
+
+	if (len == 0)
+	{
+		/* \{, \}, \$, \\ and friends stand for the character itself */
+		if (*p < end)
+		{
+			const char *next = g_utf8_next_char (*p);
+
+			append_escaped (out, *p, next - *p);
+			*p = next;
+		}
+		return;
+	}
+
+	if (len == 4 && strncmp (name, "frac", 4) == 0)
+	{
+		g_string_append (out, "<sup>");
+		math_atom (out, p, end, depth + 1);
+		g_string_append (out, "</sup>⁄<sub>");
+		math_atom (out, p, end, depth + 1);
+		g_string_append (out, "</sub>");
+		return;
+	}
+
+	if (len == 4 && strncmp (name, "sqrt", 4) == 0)
+	{
+		g_string_append (out, "√<span overline=\"single\">");
+		math_atom (out, p, end, depth + 1);
+		g_string_append (out, "</span>");
+		return;
+	}
+
+	for (guint i = 0; i < G_N_ELEMENTS (math_symbols); i++)
+	{
+		if (strlen (math_symbols[i].name) == len &&
+		    strncmp (math_symbols[i].name, name, len) == 0)
+		{
+			g_string_append (out, math_symbols[i].symbol);
+			return;
+		}
+	}
+
+	/* Unknown commands are shown verbatim so typos stay visible */
+	g_string_append_c (out, '\\');
+	append_escaped (out, name, len);
+}
+
+static void
+math_run (GString     *out,
+          const char **p,
+          const char  *end,
+          guint        depth,
+          gboolean     in_group)
+{
+	if (math_too_deep (out, p, end, depth))
+		return;
+
+	while (*p < end)
+	{
+		char c = **p;
+
+		if (c == '}' && in_group)
+		{
+			(*p)++;
+			return;
+		}
+
+		switch (c)
+		{
+		case '\\':
+			(*p)++;
+			math_command (out, p, end, depth);
+			break;
+
+		case '^':
+		case '_':
+			(*p)++;
+			g_string_append (out, c == '^' ? "<sup>" : "<sub>");
+			math_atom (out, p, end, depth + 1);
+			g_string_append (out, c == '^' ? "</sup>" : "</sub>");
+			break;
+
+		case '{':
+			(*p)++;
+			math_run (out, p, end, depth + 1, TRUE);
+			break;
+
+		case '-':
+			(*p)++;
+			g_string_append (out, "−");
+			break;
+
+		case ' ':
+			(*p)++;
+			g_string_append_c (out, ' ');
+			break;
+
+		default:
+			math_atom (out, p, end, depth);
+			break;
+		}
+	}
+}
+
+/* Finds the next unescaped @delim at or after @p, or NULL */
+static const char *
+find_closing (const char *p,
+              char        delim)
+{
+	for (; *p != '\0'; p++)
+	{
+		if (*p == '\\' && p[1] != '\0')
+			p++;
+		else if (*p == delim)
+			return p;
+	}
+
+	return NULL;
+}
+
+static void
+toggle_style (GString    *out,
+              char       *stack,
+              guint      *depth,
+              char        style,
+              const char *marker)
+{
+	const char *tag = style == 'b' ? "b" : "i";
+
+	if (*depth > 0 && stack[*depth - 1] == style)
+	{
+		(*depth)--;
+		g_string_append_printf (out, "</%s>", tag);
+	}
+	else if (memchr (stack, style, *depth) != NULL)
+	{
+		/* Closing a style that is not innermost would produce invalid
+		 * markup, so such a marker is taken literally instead.
+		 */
+		g_string_append (out, marker);
+	}
+	else
+	{
+		stack[(*depth)++] = style;
+		g_string_append_printf (out, "<%s>", tag);
+	}
+}
+
+/**
+ * atsa_rich_text_to_markup:
+ * @text: question text using the inline rich text syntax
+ *
+ * Translates @text into Pango markup. The result is always well formed,
+ * unbalanced or unknown constructs are passed through as plain text.
+ *
+ * Returns: (transfer full): the markup
+ */
+char *
+atsa_rich_text_to_markup (const char *text)
+{
+	g_autofree char *valid = NULL;
+	GString *out;
+	const char *p;
+	char stack[2];
+	guint depth = 0;
+
+	g_return_val_if_fail (text != NULL, NULL);
+
+	valid = g_utf8_make_valid (text, -1);
+	out = g_string_sized_new (strlen (valid) + 16);
+	p = valid;
+
+	while (*p != '\0')
+	{
+		const char *close;
+
+		switch (*p)
+		{
+		case '\\':
+			if (p[1] == '*' || p[1] == '$' || p[1] == '`' || p[1] == '\\')
+			{
+				append_escaped (out, p + 1, 1);
+				p += 2;
+			}
+			else
+			{
+				g_string_append_c (out, '\\');
+				p++;
+			}
+			break;
+
+		case '*':
+			if (p[1] == '*')
+			{
+				toggle_style (out, stack, &depth, 'b', "**");
+				p += 2;
+			}
+			else
+			{
+				toggle_style (out, stack, &depth, 'i', "*");
+				p++;
+			}
+			break;
+
+		case '`':
+		case '$':
+			close = find_closing (p + 1, *p);
+			if (close == NULL)
+			{
+				append_escaped (out, p, 1);
+				p++;
+				break;
+			}
+
+			if (*p == '`')
+			{
+				g_string_append (out, "<tt>");
+				append_escaped (out, p + 1, close - (p + 1));
+				g_string_append (out, "</tt>");
+			}
+			else
+			{
+				const char *math = p + 1;
+
+				g_string_append (out, "<span font_family=\"serif\">");
+				math_run (out, &math, close, 0, FALSE);
+				g_string_append (out, "</span>");
+			}
+			p = close + 1;
+			break;
+
+		default:
+			{
+				const char *next = g_utf8_next_char (p);
+
+				append_escaped (out, p, next - p);
+				p = next;
+			}
+			break;
+		}
+	}
+
+	while (depth > 0)
+		g_string_append_printf (out, "</%s>", stack[--depth] == 'b' ? "b" : "i");
+
+	return g_string_free (out, FALSE);
+}
+
+/**
+ * atsa_rich_text_create_layout:
+ * @cr: the cairo context the layout will be drawn on
+ * @markup: Pango markup, as made by atsa_rich_text_to_markup()
+ * @font: a font description string
+ * @width: the width to wrap at in user units, or -1 for no wrapping
+ *
+ * Creates a layout for @markup. Only uses @cr, so it may be called from any
+ * thread that owns @cr.
+ *
+ * Returns: (transfer full): a new #PangoLayout
+ */
+PangoLayout *
+atsa_rich_text_create_layout (cairo_t    *cr,
+                              const char *markup,
+                              const char *font,
+                              int         width)
+{
+	PangoLayout *layout;
+	PangoFontDescription *desc;
+
+	layout = pango_cairo_create_layout (cr);
+
+	desc = pango_font_description_from_string (font);
+	pango_layout_set_font_description (layout, desc);
+	pango_font_description_free (desc);
+
+	if (width > 0)
+		pango_layout_set_width (layout, width * PANGO_SCALE);
+	pango_layout_set_wrap (layout, PANGO_WRAP_WORD_CHAR);
+
+	pango_layout_set_markup (layout, markup, -1);
+
+	return layout;
+}
+
+typedef struct
+{
+	char       *key;
+	int         width;
+	/* %NULL if the text couldn't be rendered */
+	GdkTexture *texture;
+	int         height;
+	gsize       n_bytes;
+	GList       link;
+} CacheEntry;
+
+typedef struct
+{
+	int           width;
+	GCancellable *cancellable;
+} PendingRender;
+
+typedef struct
+{
+	char                 *markup;
+	char                 *font;
+	/* Of the widget's Pango context, -1 for the default */
+	double                resolution;
+	cairo_font_options_t *font_options;
+	int                   width;
+	int                   scale;
+	/* Set by the worker, in logical pixels */
+	int                   height;
+} RenderJob;
+
+struct _AtsaRichTextCache
+{
+	GObject     parent_instance;
+
+	/* key → CacheEntry, most recently used entry at the head of @lru */
+	GHashTable *entries;
+	GQueue      lru;
+	/* key → PendingRender, so each one is only rendered once at a time */
+	GHashTable *pending;
+
+	gsize       max_bytes;
+	gsize       n_bytes;
+};
+
+G_DEFINE_FINAL_TYPE (AtsaRichTextCache, atsa_rich_text_cache, G_TYPE_OBJECT)
+
+enum {
+	RENDERED,
+	N_SIGNALS
+};
+
+static guint signals[N_SIGNALS];
+
+static void
+cache_entry_free (CacheEntry *entry)
+{
+	g_free (entry->key);
+	g_clear_object (&entry->texture);
+	g_free (entry);
+}
+
+static void
+pending_render_free (PendingRender *pending)
+{
+	g_object_unref (pending->cancellable);
+	g_free (pending);
+}
+
+static void
+render_job_free (RenderJob *job)
+{
+	g_free (job->markup);
+	g_free (job->font);
+	g_clear_pointer (&job->font_options, cairo_font_options_destroy);
+	g_free (job);
+}
+
+static char *
+make_key (const char                 *markup,
+          const char                 *font,
+          double                      resolution,
+          const cairo_font_options_t *font_options,
+          int                         scale)
+{
+	gulong options_hash = font_options != NULL ? cairo_font_options_hash (font_options) : 0;
+
+	return g_strdup_printf ("%d:%g:%lx:%s\x1f%s",
+	                        scale, resolution, options_hash, font, markup);
+}
+
+/* Returns the height of @layout in logical pixels when painted at @scale.
+ * Hinted metrics depend on the device scale, so this has to match the
+ * transformation the layout is painted with.
+ */
+static int
+measure_layout (PangoLayout *layout,
+                int          scale)
+{
+	cairo_surface_t *surface;
+	cairo_t *cr;
+	PangoRectangle logical;
+
+	surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 1, 1);
+	cr = cairo_create (surface);
+	cairo_scale (cr, scale, scale);
+	pango_cairo_update_layout (cr, layout);
+	pango_layout_get_pixel_extents (layout, NULL, &logical);
+	cairo_destroy (cr);
+	cairo_surface_destroy (surface);
+
+	return MAX (logical.height, 1);
+}
+
+static void
+render_thread (GTask        *task,
+               gpointer      source_object,
+               gpointer      task_data,
+               GCancellable *cancellable)
+{
+	RenderJob *job = task_data;
+	cairo_surface_t *surface;
+	cairo_t *cr;
+	PangoLayout *layout;
+	GdkTexture *texture;
+	GBytes *bytes;
+	int scale = job->scale;
+	int height;
+
+	surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 1, 1);
+	cr = cairo_create (surface);
+	layout = atsa_rich_text_create_layout (cr, job->markup, job->font, job->width);
+	cairo_destroy (cr);
+	cairo_surface_destroy (surface);
+
+	/* Lay out like the widget would, worker threads have a default context */
+	pango_cairo_context_set_resolution (pango_layout_get_context (layout), job->resolution);
+	pango_cairo_context_set_font_options (pango_layout_get_context (layout), job->font_options);
+	pango_layout_context_changed (layout);
+
+	height = measure_layout (layout, scale);
+
+	/* Text too tall for one surface is rendered at a lower scale, and left
+	 * to the label to draw if even that is not enough.
+	 */
+	if (MAX (height, job->width) * scale > MAX_SURFACE_SIZE && scale > 1)
+	{
+		scale = MAX (MAX_SURFACE_SIZE / MAX (height, job->width), 1);
+		height = measure_layout (layout, scale);
+	}
+	job->height = height;
+
+	/* Painting is the expensive part, skip it for a width nobody wants */
+	if (g_task_return_error_if_cancelled (task))
+	{
+		g_object_unref (layout);
+		return;
+	}
+
+	surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+	                                      job->width * scale,
+	                                      height * scale);
+	if (cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS)
+	{
+		g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+		                         "%s", cairo_status_to_string (cairo_surface_status (surface)));
+		cairo_surface_destroy (surface);
+		g_object_unref (layout);
+		return;
+	}
+
+	cr = cairo_create (surface);
+	cairo_scale (cr, scale, scale);
+	pango_cairo_update_layout (cr, layout);
+
+	/* Painted white and tinted to the widget's colour when drawn, so the
+	 * cached texture does not depend on the theme.
+	 */
+	cairo_set_source_rgb (cr, 1, 1, 1);
+	pango_cairo_show_layout (cr, layout);
+	cairo_destroy (cr);
+	g_object_unref (layout);
+
+	cairo_surface_flush (surface);
+	bytes = g_bytes_new_with_free_func (cairo_image_surface_get_data (surface),
+	                                    cairo_image_surface_get_stride (surface) *
+	                                    cairo_image_surface_get_height (surface),
+	                                    (GDestroyNotify) cairo_surface_destroy,
+	                                    surface);
+	texture = gdk_memory_texture_new (cairo_image_surface_get_width (surface),
+	                                  cairo_image_surface_get_height (surface),
+	                                  GDK_MEMORY_DEFAULT,
+	                                  bytes,
+	                                  cairo_image_surface_get_stride (surface));
+	g_bytes_unref (bytes);
+
+	g_task_return_pointer (task, texture, g_object_unref);
+}
+
+static void
+atsa_rich_text_cache_remove (AtsaRichTextCache *self,
+                             CacheEntry        *entry)
+{
+	g_queue_unlink (&self->lru, &entry->link);
+	self->n_bytes -= entry->n_bytes;
+	g_hash_table_remove (self->entries, entry->key);
+}
+
+static void
+atsa_rich_text_cache_evict (AtsaRichTextCache *self)
+{
+	/* Always keep the newest entry, even if it alone is over budget */
+	while (self->n_bytes > self->max_bytes && self->lru.length > 1)
+	{
+		atsa_rich_text_cache_remove (self, g_queue_peek_tail (&self->lru));
+	}
+}
+
+static void
+render_done_cb (GObject      *source_object,
+                GAsyncResult *result,
+                gpointer      user_data)
+{
+	AtsaRichTextCache *self = ATSA_RICH_TEXT_CACHE (source_object);
+	RenderJob *job = g_task_get_task_data (G_TASK (result));
+	g_autofree char *key = user_data;
+	g_autoptr(GError) error = NULL;
+	PendingRender *pending;
+	GdkTexture *texture;
+	CacheEntry *entry;
+
+	/* A newer request for another width may have taken over the key */
+	pending = g_hash_table_lookup (self->pending, key);
+	if (pending != NULL && pending->cancellable == g_task_get_cancellable (G_TASK (result)))
+		g_hash_table_remove (self->pending, key);
+
+	texture = g_task_propagate_pointer (G_TASK (result), &error);
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		return;
+
+	/* Failures are cached too, so the label falls back to drawing the
+	 * text itself instead of asking for the same rendering again.
+	 */
+	if (texture == NULL)
+		g_warning ("Failed to render text: %s", error->message);
+
+	entry = g_hash_table_lookup (self->entries, key);
+	if (entry != NULL)
+		atsa_rich_text_cache_remove (self, entry);
+
+	entry = g_new0 (CacheEntry, 1);
+	entry->key = g_steal_pointer (&key);
+	entry->width = job->width;
+	entry->texture = texture;
+	entry->height = job->height;
+	if (texture != NULL)
+		entry->n_bytes = (gsize) gdk_texture_get_width (texture) * gdk_texture_get_height (texture) * 4;
+	else
+		entry->n_bytes = strlen (entry->key);
+	entry->link.data = entry;
+
+	g_hash_table_replace (self->entries, entry->key, entry);
+	g_queue_push_head_link (&self->lru, &entry->link);
+	self->n_bytes += entry->n_bytes;
+
+	atsa_rich_text_cache_evict (self);
+
+	g_signal_emit (self, signals[RENDERED], 0, job->markup);
+}
+
+/**
+ * atsa_rich_text_cache_lookup:
+ * @self: a #AtsaRichTextCache
+ * @markup: Pango markup, as made by atsa_rich_text_to_markup()
+ * @context: the Pango context of the widget the text is for
+ * @width: the width to wrap at, in logical pixels
+ * @scale: the scale factor of the surface the texture will be drawn on
+ * @texture: (out) (optional) (transfer none) (nullable): return location
+ *   for the texture, %NULL if the text couldn't be rendered
+ * @height: (out) (optional): return location for the height in logical pixels
+ *
+ * Looks up the rendering of @markup. On a miss the text is laid out on a
+ * worker thread and #AtsaRichTextCache::rendered is emitted once it is
+ * available. A rendering of the same text for another width that is still
+ * in flight is cancelled.
+ *
+ * Returns: %TRUE if the rendering was cached
+ */
+gboolean
+atsa_rich_text_cache_lookup (AtsaRichTextCache  *self,
+                             const char         *markup,
+                             PangoContext       *context,
+                             int                 width,
+                             int                 scale,
+                             GdkTexture        **texture,
+                             int                *height)
+{
+	g_autofree char *key = NULL;
+	g_autofree char *font = NULL;
+	const cairo_font_options_t *font_options;
+	double resolution;
+	CacheEntry *entry;
+	PendingRender *pending;
+	RenderJob *job;
+	GTask *task;
+
+	g_return_val_if_fail (ATSA_IS_RICH_TEXT_CACHE (self), FALSE);
+	g_return_val_if_fail (markup != NULL, FALSE);
+	g_return_val_if_fail (PANGO_IS_CONTEXT (context), FALSE);
+
+	if (width <= 0)
+		return FALSE;
+
+	scale = MAX (scale, 1);
+	font = pango_font_description_to_string (pango_context_get_font_description (context));
+	resolution = pango_cairo_context_get_resolution (context);
+	font_options = pango_cairo_context_get_font_options (context);
+	key = make_key (markup, font, resolution, font_options, scale);
+
+	entry = g_hash_table_lookup (self->entries, key);
+	if (entry != NULL && entry->width == width)
+	{
+		g_queue_unlink (&self->lru, &entry->link);
+		g_queue_push_head_link (&self->lru, &entry->link);
+
+		if (texture != NULL)
+			*texture = entry->texture;
+		if (height != NULL)
+			*height = entry->height;
+
+		return TRUE;
+	}
+
+	pending = g_hash_table_lookup (self->pending, key);
+	if (pending != NULL && pending->width == width)
+		return FALSE;
+
+	if (pending != NULL)
+		g_cancellable_cancel (pending->cancellable);
+
+	job = g_new0 (RenderJob, 1);
+	job->markup = g_strdup (markup);
+	job->font = g_steal_pointer (&font);
+	job->resolution = resolution;
+	if (font_options != NULL)
+		job->font_options = cairo_font_options_copy (font_options);
+	job->width = width;
+	job->scale = scale;
+
+	pending = g_new0 (PendingRender, 1);
+	pending->width = width;
+	pending->cancellable = g_cancellable_new ();
+	g_hash_table_replace (self->pending, g_strdup (key), pending);
+
+	task = g_task_new (self, pending->cancellable, render_done_cb, g_steal_pointer (&key));
+	g_task_set_source_tag (task, atsa_rich_text_cache_lookup);
+	g_task_set_task_data (task, job, (GDestroyNotify) render_job_free);
+	g_task_run_in_thread (task, render_thread);
+	g_object_unref (task);
+
+	return FALSE;
+}
+
+/**
+ * atsa_rich_text_cache_new:
+ * @max_bytes: upper bound for the memory used by cached textures
+ *
+ * Returns: (transfer full): a new #AtsaRichTextCache
+ */
+AtsaRichTextCache *
+atsa_rich_text_cache_new (gsize max_bytes)
+{
+	AtsaRichTextCache *self = g_object_new (ATSA_TYPE_RICH_TEXT_CACHE, NULL);
+
+	self->max_bytes = max_bytes;
+
+	return self;
+}
+
+/**
+ * atsa_rich_text_cache_get_default:
+ *
+ * Returns: (transfer none): the cache shared by all widgets of the application
+ */
+AtsaRichTextCache *
+atsa_rich_text_cache_get_default (void)
+{
+	static AtsaRichTextCache *default_cache;
+
+	g_assert (g_main_context_is_owner (g_main_context_default ()));
+
+	if (default_cache == NULL)
+		default_cache = atsa_rich_text_cache_new (DEFAULT_CACHE_BYTES);
+
+	return default_cache;
+}
+
+static void
+atsa_rich_text_cache_finalize (GObject *object)
+{
+	AtsaRichTextCache *self = ATSA_RICH_TEXT_CACHE (object);
+
+	/* Entries are only owned by the hash table, the queue just links them */
+	g_queue_init (&self->lru);
+	g_clear_pointer (&self->entries, g_hash_table_unref);
+	g_clear_pointer (&self->pending, g_hash_table_unref);
+
+	G_OBJECT_CLASS (atsa_rich_text_cache_parent_class)->finalize (object);
+}
+
+static void
+atsa_rich_text_cache_class_init (AtsaRichTextCacheClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = atsa_rich_text_cache_finalize;
+
+	/**
+	 * AtsaRichTextCache::rendered:
+	 * @self: the cache
+	 * @markup: the markup that finished rendering
+	 *
+	 * Emitted on the main thread when a rendering requested through
+	 * atsa_rich_text_cache_lookup() has been added to the cache.
+	 */
+	signals[RENDERED] = g_signal_new ("rendered",
+	                                  G_TYPE_FROM_CLASS (klass),
+	                                  G_SIGNAL_RUN_LAST,
+	                                  0, NULL, NULL, NULL,
+	                                  G_TYPE_NONE, 1,
+	                                  G_TYPE_STRING | G_SIGNAL_TYPE_STATIC_SCOPE);
+}
+
+static void
+atsa_rich_text_cache_init (AtsaRichTextCache *self)
+{
+	self->entries = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                       NULL, (GDestroyNotify) cache_entry_free);
+	self->pending = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                       g_free, (GDestroyNotify) pending_render_free);
+	self->max_bytes = DEFAULT_CACHE_BYTES;
+	g_queue_init (&self->lru);
+}
@@ -0,0 +1,48 @@
+/* atsa-rich-text.h
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+#include <pango/pangocairo.h>
+
+G_BEGIN_DECLS
+
+char        *atsa_rich_text_to_markup      (const char *text);
+PangoLayout *atsa_rich_text_create_layout  (cairo_t    *cr,
+                                            const char *markup,
+                                            const char *font,
+                                            int         width);
+
+#define ATSA_TYPE_RICH_TEXT_CACHE (atsa_rich_text_cache_get_type())
+
+G_DECLARE_FINAL_TYPE (AtsaRichTextCache, atsa_rich_text_cache, ATSA, RICH_TEXT_CACHE, GObject)
+
+AtsaRichTextCache *atsa_rich_text_cache_new         (gsize              max_bytes);
+AtsaRichTextCache *atsa_rich_text_cache_get_default (void);
+gboolean           atsa_rich_text_cache_lookup      (AtsaRichTextCache  *self,
+                                                     const char         *markup,
+                                                     PangoContext       *context,
+                                                     int                 width,
+                                                     int                 scale,
+                                                     GdkTexture        **texture,
+                                                     int                *height);
+
+G_END_DECLS
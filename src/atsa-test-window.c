@@ -1,14 +1,39 @@
 #include "atsa-test-window.h"
 #include <glib/gi18n.h> // For _() macro if you use translatable strings
 
+#include "atsa-application.h"
+#include "atsa-export.h"
+#include "atsa-question-bank.h"
+#include "atsa-rich-label.h"
+
 struct _AtsaTestWindow
 {
   AdwWindow parent_instance;
   gchar *yaml_file_path; // Store the path to the YAML file
+  AtsaQuestionBank *bank;
+
+  AdwToolbarView *toolbar_view;
+  AdwToastOverlay *toast_overlay;
+  GtkSpinButton *variants_button;
+  GtkStringList *questions; // Markup of each question
+  GStrv question_texts; // The same without markup, for assistive technologies
+  GCancellable *load_cancellable;
+
+  // Printing and exporting use the same seed, so printed answer keys
+  // match exported variants from the same window.
+  guint32 seed;
+  GtkPrintOperation *print_operation;
+  GCancellable *export_cancellable;
 };
 
 G_DEFINE_FINAL_TYPE (AtsaTestWindow, atsa_test_window, ADW_TYPE_WINDOW)
 
+// --- GObject Properties Registration ---
+enum {
+  PROP_0,
+  PROP_YAML_FILE_PATH // Property ID for yaml_file_path
+};
+
 // Constructor for AtsaTestWindow
 AtsaTestWindow *
 atsa_test_window_new (GtkApplication *app, const gchar *yaml_file_path)
@@ -16,6 +41,7 @@ atsa_test_window_new (GtkApplication *app, const gchar *yaml_file_path)
   return g_object_new (ATSA_TYPE_TEST_WINDOW,
                        "application", app,
                        "title", _("Atsa Test"),
+                       "yaml-file-path", yaml_file_path,
                        NULL);
 }
 
@@ -26,22 +52,328 @@ atsa_test_window_set_yaml_file_path (AtsaTestWindow *self, const gchar *yaml_fil
   g_clear_pointer (&self->yaml_file_path, g_free); // Free old path if exists
   self->yaml_file_path = g_strdup (yaml_file_path); // Duplicate the string
   g_print ("AtsaTestWindow created. Will load questions from: %s\n", self->yaml_file_path);
-  // TODO: In future steps, this is where you'll call Rust FFI to load questions
-  // load_questions_into_memory(self->yaml_file_path);
 }
 
+// Everything the list needs, prepared off the main thread
+typedef struct
+{
+  AtsaQuestionBank *bank;
+  GStrv markup;
+  GStrv texts;
+} LoadedQuestions;
+
 static void
-atsa_test_window_init (AtsaTestWindow *self)
+loaded_questions_free (LoadedQuestions *loaded)
 {
-  // Set default size (optional, can also be done in CSS or UI file)
-  gtk_window_set_default_size (GTK_WINDOW (self), 800, 600);
+  g_clear_pointer (&loaded->bank, atsa_question_bank_unref);
+  g_strfreev (loaded->markup);
+  g_strfreev (loaded->texts);
+  g_free (loaded);
+}
+
+static void
+load_questions_thread (GTask        *task,
+                       gpointer      source_object,
+                       gpointer      task_data,
+                       GCancellable *cancellable)
+{
+  const gchar *path = task_data;
+  LoadedQuestions *loaded;
+  GError *error = NULL;
+  guint n_questions;
+
+  loaded = g_new0 (LoadedQuestions, 1);
+  loaded->bank = atsa_question_bank_load (path, &error);
+  if (loaded->bank == NULL)
+  {
+    loaded_questions_free (loaded);
+    g_task_return_error (task, error);
+    return;
+  }
+
+  n_questions = atsa_question_bank_get_n_questions (loaded->bank);
+  loaded->markup = g_new0 (gchar *, n_questions + 1);
+  loaded->texts = g_new0 (gchar *, n_questions + 1);
+
+  for (guint i = 0; i < n_questions; i++)
+  {
+    const AtsaQuestion *question = atsa_question_bank_get_question (loaded->bank, i);
+
+    if (g_cancellable_is_cancelled (cancellable))
+      break;
+
+    loaded->markup[i] = atsa_question_to_markup (question, i + 1, NULL, FALSE);
+
+    // Parsed once here rather than on every bind while scrolling
+    if (!pango_parse_markup (loaded->markup[i], -1, 0, NULL, &loaded->texts[i], NULL, NULL))
+      loaded->texts[i] = g_strdup ("");
+  }
+
+  if (g_task_return_error_if_cancelled (task))
+  {
+    loaded_questions_free (loaded);
+    return;
+  }
 
+  g_task_return_pointer (task, loaded, (GDestroyNotify) loaded_questions_free);
 }
 
 static void
-atsa_test_window_class_init (AtsaTestWindowClass *klass)
+load_questions_cb (GObject      *source_object,
+                   GAsyncResult *res,
+                   gpointer      user_data)
+{
+  AtsaTestWindow *self = ATSA_TEST_WINDOW (source_object);
+  LoadedQuestions *loaded;
+  GtkApplication *application;
+  g_autoptr(GError) error = NULL;
+
+  loaded = g_task_propagate_pointer (G_TASK (res), &error);
+  g_clear_object (&self->load_cancellable);
+  if (loaded == NULL)
+  {
+    // Cancelled when the window went away
+    if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      return;
+
+    g_printerr ("%s\n", error->message);
+    adw_toolbar_view_set_content (self->toolbar_view,
+                                  g_object_new (ADW_TYPE_STATUS_PAGE,
+                                                "icon-name", "dialog-error-symbolic",
+                                                "title", _("Could Not Load Questions"),
+                                                "description", error->message,
+                                                NULL));
+    return;
+  }
+
+  self->bank = g_steal_pointer (&loaded->bank);
+  self->question_texts = g_steal_pointer (&loaded->texts);
+  gtk_string_list_splice (self->questions, 0,
+                          g_list_model_get_n_items (G_LIST_MODEL (self->questions)),
+                          (const char * const *) loaded->markup);
+  loaded_questions_free (loaded);
+
+  gtk_widget_action_set_enabled (GTK_WIDGET (self), "win.print", TRUE);
+  gtk_widget_action_set_enabled (GTK_WIDGET (self), "win.export-pdf", TRUE);
+
+  // Make the questions available to the review mode as well
+  application = gtk_window_get_application (GTK_WINDOW (self));
+  if (ATSA_IS_APPLICATION (application))
+  {
+    AtsaReviewScheduler *scheduler = atsa_application_get_review_scheduler (ATSA_APPLICATION (application));
+
+    if (scheduler != NULL)
+      atsa_review_scheduler_add_bank (scheduler, self->bank, g_get_real_time () / G_USEC_PER_SEC);
+  }
+}
+
+// Loading and converting a large bank takes a while, so it runs in a
+// thread and the list fills in once it is done.
+static void
+atsa_test_window_load_questions (AtsaTestWindow *self)
+{
+  g_autoptr(GTask) task = NULL;
+
+  if (self->yaml_file_path == NULL)
+    return;
+
+  self->load_cancellable = g_cancellable_new ();
+  task = g_task_new (self, self->load_cancellable, load_questions_cb, NULL);
+  g_task_set_source_tag (task, atsa_test_window_load_questions);
+  g_task_set_task_data (task, g_strdup (self->yaml_file_path), g_free);
+  g_task_run_in_thread (task, load_questions_thread);
+}
+
+static void
+atsa_test_window_print_action (GtkWidget  *widget,
+                               const char *action_name,
+                               GVariant   *parameter)
+{
+  AtsaTestWindow *self = ATSA_TEST_WINDOW (widget);
+  g_autoptr(GError) error = NULL;
+
+  if (self->bank == NULL)
+    return;
+
+  // Kept until the next print so an async print job can outlive this call
+  g_clear_object (&self->print_operation);
+  self->print_operation = atsa_export_print_operation_new (self->bank,
+                                                           gtk_spin_button_get_value_as_int (self->variants_button),
+                                                           self->seed,
+                                                           TRUE);
+  gtk_print_operation_set_allow_async (self->print_operation, TRUE);
+
+  if (gtk_print_operation_run (self->print_operation,
+                               GTK_PRINT_OPERATION_ACTION_PRINT_DIALOG,
+                               GTK_WINDOW (self),
+                               &error) == GTK_PRINT_OPERATION_RESULT_ERROR)
+    adw_toast_overlay_add_toast (self->toast_overlay, adw_toast_new (error->message));
+}
+
+static void
+export_variants_cb (GObject      *source_object,
+                    GAsyncResult *res,
+                    gpointer      user_data)
+{
+  g_autoptr(AtsaTestWindow) self = user_data;
+  g_autoptr(GError) error = NULL;
+  gboolean success;
+
+  success = atsa_export_variants_finish (res, &error);
+
+  // The window may have been closed while the export ran; the ref only
+  // keeps the object alive, its widgets are gone after dispose.
+  if (gtk_widget_in_destruction (GTK_WIDGET (self)) || self->toast_overlay == NULL)
+    return;
+
+  gtk_widget_action_set_enabled (GTK_WIDGET (self), "win.export-pdf", TRUE);
+  g_clear_object (&self->export_cancellable);
+
+  if (!success)
+  {
+    if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      adw_toast_overlay_add_toast (self->toast_overlay, adw_toast_new (error->message));
+    return;
+  }
+
+  adw_toast_overlay_add_toast (self->toast_overlay, adw_toast_new (_("Variants exported")));
+}
+
+static void
+export_folder_dialog_response_cb (GObject      *source_object,
+                                  GAsyncResult *res,
+                                  gpointer      user_data)
+{
+  g_autoptr(AtsaTestWindow) self = user_data;
+  g_autoptr(GFile) folder = NULL;
+  g_autofree gchar *path = NULL;
+
+  folder = gtk_file_dialog_select_folder_finish (GTK_FILE_DIALOG (source_object), res, NULL);
+  if (folder == NULL || self->bank == NULL)
+    return;
+
+  path = g_file_get_path (folder);
+
+  // Rendering runs on one worker per core, the window stays responsive
+  gtk_widget_action_set_enabled (GTK_WIDGET (self), "win.export-pdf", FALSE);
+  self->export_cancellable = g_cancellable_new ();
+  atsa_export_variants_async (self->bank,
+                              gtk_spin_button_get_value_as_int (self->variants_button),
+                              self->seed,
+                              path,
+                              self->export_cancellable,
+                              export_variants_cb,
+                              g_object_ref (self));
+}
+
+static void
+atsa_test_window_export_pdf_action (GtkWidget  *widget,
+                                    const char *action_name,
+                                    GVariant   *parameter)
+{
+  AtsaTestWindow *self = ATSA_TEST_WINDOW (widget);
+  g_autoptr(GtkFileDialog) dialog = NULL;
+
+  dialog = gtk_file_dialog_new ();
+  gtk_file_dialog_set_title (dialog, _("Export Variants"));
+  gtk_file_dialog_set_modal (dialog, TRUE);
+  gtk_file_dialog_select_folder (dialog,
+                                 GTK_WINDOW (self),
+                                 NULL,
+                                 export_folder_dialog_response_cb,
+                                 g_object_ref (self));
+}
+
+static void
+setup_question_row_cb (GtkSignalListItemFactory *factory,
+                       GtkListItem              *list_item,
+                       gpointer                  user_data)
+{
+  GtkWidget *label = atsa_rich_label_new (NULL);
+
+  gtk_widget_set_margin_top (label, 12);
+  gtk_widget_set_margin_bottom (label, 12);
+  gtk_widget_set_margin_start (label, 18);
+  gtk_widget_set_margin_end (label, 18);
+  gtk_list_item_set_child (list_item, label);
+}
+
+static void
+bind_question_row_cb (GtkSignalListItemFactory *factory,
+                      GtkListItem              *list_item,
+                      gpointer                  user_data)
 {
-  // No specific class members or methods for now
+  AtsaTestWindow *self = user_data;
+  GtkStringObject *item = gtk_list_item_get_item (list_item);
+  guint position = gtk_list_item_get_position (list_item);
+
+  atsa_rich_label_set_markup_with_text (ATSA_RICH_LABEL (gtk_list_item_get_child (list_item)),
+                                        gtk_string_object_get_string (item),
+                                        self->question_texts[position]);
+}
+
+static void
+atsa_test_window_init (AtsaTestWindow *self)
+{
+  GtkListItemFactory *factory;
+  GtkWidget *list_view;
+  GtkWidget *scrolled_window;
+  GtkWidget *header_bar;
+  GtkWidget *button;
+
+  // Set default size (optional, can also be done in CSS or UI file)
+  gtk_window_set_default_size (GTK_WINDOW (self), 800, 600);
+
+  self->questions = gtk_string_list_new (NULL);
+  self->seed = g_random_int ();
+
+  // Enabled once the questions are loaded
+  gtk_widget_action_set_enabled (GTK_WIDGET (self), "win.print", FALSE);
+  gtk_widget_action_set_enabled (GTK_WIDGET (self), "win.export-pdf", FALSE);
+
+  // Rows only hold a rich label; all text layout happens off the main
+  // thread in AtsaRichTextCache so scrolling stays smooth.
+  factory = gtk_signal_list_item_factory_new ();
+  g_signal_connect (factory, "setup", G_CALLBACK (setup_question_row_cb), NULL);
+  g_signal_connect (factory, "bind", G_CALLBACK (bind_question_row_cb), self);
+
+  list_view = gtk_list_view_new (GTK_SELECTION_MODEL (gtk_no_selection_new (G_LIST_MODEL (g_object_ref (self->questions)))),
+                                 factory);
+  gtk_list_view_set_show_separators (GTK_LIST_VIEW (list_view), TRUE);
+
+  scrolled_window = gtk_scrolled_window_new ();
+  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled_window),
+                                  GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+  gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (scrolled_window), list_view);
+
+  header_bar = adw_header_bar_new ();
+
+  button = gtk_button_new_with_mnemonic (_("_Review"));
+  gtk_widget_set_tooltip_text (button, _("Study Due Questions"));
+  gtk_actionable_set_action_name (GTK_ACTIONABLE (button), "app.review");
+  adw_header_bar_pack_start (ADW_HEADER_BAR (header_bar), button);
+
+  button = gtk_button_new_from_icon_name ("document-print-symbolic");
+  gtk_widget_set_tooltip_text (button, _("Print Variants"));
+  gtk_actionable_set_action_name (GTK_ACTIONABLE (button), "win.print");
+  adw_header_bar_pack_end (ADW_HEADER_BAR (header_bar), button);
+
+  button = gtk_button_new_from_icon_name ("document-save-symbolic");
+  gtk_widget_set_tooltip_text (button, _("Export Variants as PDF"));
+  gtk_actionable_set_action_name (GTK_ACTIONABLE (button), "win.export-pdf");
+  adw_header_bar_pack_end (ADW_HEADER_BAR (header_bar), button);
+
+  self->variants_button = GTK_SPIN_BUTTON (gtk_spin_button_new_with_range (1, 999, 1));
+  gtk_widget_set_tooltip_text (GTK_WIDGET (self->variants_button), _("Number of Variants"));
+  adw_header_bar_pack_end (ADW_HEADER_BAR (header_bar), GTK_WIDGET (self->variants_button));
+
+  self->toast_overlay = ADW_TOAST_OVERLAY (adw_toast_overlay_new ());
+  adw_toast_overlay_set_child (self->toast_overlay, scrolled_window);
+
+  self->toolbar_view = ADW_TOOLBAR_VIEW (adw_toolbar_view_new ());
+  adw_toolbar_view_add_top_bar (self->toolbar_view, header_bar);
+  adw_toolbar_view_set_content (self->toolbar_view, GTK_WIDGET (self->toast_overlay));
+  adw_window_set_content (ADW_WINDOW (self), GTK_WIDGET (self->toolbar_view));
 }
 
 // GObject property setter for 'yaml-file-path'
@@ -52,7 +384,7 @@ atsa_test_window_set_property (GObject *object, guint prop_id, const GValue *val
 
   switch (prop_id)
   {
-    case 1: // Custom property ID for yaml_file_path (you could use a define for this)
+    case PROP_YAML_FILE_PATH:
       atsa_test_window_set_yaml_file_path (self, g_value_get_string (value));
       break;
     default:
@@ -69,7 +401,7 @@ atsa_test_window_get_property (GObject *object, guint prop_id, GValue *value, GP
 
   switch (prop_id)
   {
-    case 1:
+    case PROP_YAML_FILE_PATH:
       g_value_set_string (value, self->yaml_file_path);
       break;
     default:
@@ -78,12 +410,32 @@ atsa_test_window_get_property (GObject *object, guint prop_id, GValue *value, GP
   }
 }
 
+// Construct-only properties are set by now, so the questions can be loaded
+static void
+atsa_test_window_constructed (GObject *object)
+{
+  AtsaTestWindow *self = ATSA_TEST_WINDOW (object);
+
+  G_OBJECT_CLASS (atsa_test_window_parent_class)->constructed (object);
+
+  atsa_test_window_load_questions (self);
+}
+
 // Override dispose to free allocated memory
 static void
 atsa_test_window_dispose (GObject *object)
 {
   AtsaTestWindow *self = ATSA_TEST_WINDOW (object);
   g_clear_pointer (&self->yaml_file_path, g_free);
+  g_clear_pointer (&self->bank, atsa_question_bank_unref);
+  g_clear_object (&self->questions);
+  g_clear_pointer (&self->question_texts, g_strfreev);
+  g_cancellable_cancel (self->load_cancellable);
+  g_clear_object (&self->load_cancellable);
+  g_clear_object (&self->print_operation);
+  g_cancellable_cancel (self->export_cancellable);
+  g_clear_object (&self->export_cancellable);
+  self->toast_overlay = NULL; // Owned by the widget tree torn down below
   G_OBJECT_CLASS (atsa_test_window_parent_class)->dispose (object);
 }
 
@@ -95,29 +447,27 @@ atsa_test_window_finalize (GObject *object)
   G_OBJECT_CLASS (atsa_test_window_parent_class)->finalize (object);
 }
 
-// --- GObject Properties Registration ---
-enum {
-  PROP_0,
-  PROP_YAML_FILE_PATH // Property ID for yaml_file_path
-};
-
 static void
-atsa_test_window_class_init_properties (AtsaTestWindowClass *klass)
+atsa_test_window_class_init (AtsaTestWindowClass *klass)
 {
-  g_object_class_install_property (G_OBJECT_CLASS (klass),
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->set_property = atsa_test_window_set_property;
+  object_class->get_property = atsa_test_window_get_property;
+  object_class->constructed = atsa_test_window_constructed;
+  object_class->dispose = atsa_test_window_dispose;
+  object_class->finalize = atsa_test_window_finalize;
+
+  g_object_class_install_property (object_class,
                                    PROP_YAML_FILE_PATH,
                                    g_param_spec_string ("yaml-file-path",
                                                         "YAML File Path",
                                                         "Path to the YAML file containing questions.",
                                                         NULL, // default value
                                                         G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
-}
 
-// Connect set_property and get_property
-void atsa_test_window_register_properties(AtsaTestWindowClass *klass) {
-    G_OBJECT_CLASS(klass)->set_property = atsa_test_window_set_property;
-    G_OBJECT_CLASS(klass)->get_property = atsa_test_window_get_property;
-    atsa_test_window_class_init_properties(klass);
+  gtk_widget_class_install_action (GTK_WIDGET_CLASS (klass), "win.print", NULL,
+                                   atsa_test_window_print_action);
+  gtk_widget_class_install_action (GTK_WIDGET_CLASS (klass), "win.export-pdf", NULL,
+                                   atsa_test_window_export_pdf_action);
 }
-
-
@@ -0,0 +1,137 @@
+/* atsa-worker-pool.c
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include "atsa-worker-pool.h"
+
+typedef struct
+{
+	AtsaWorkerFunc  func;
+	gpointer        user_data;
+
+	/* A private cancellable so a failing worker can stop the others
+	 * without cancelling the caller's.
+	 */
+	GCancellable   *cancellable;
+	GMutex          mutex;
+	/* The first error, later ones are usually just G_IO_ERROR_CANCELLED */
+	GError         *error;
+} WorkerPool;
+
+static void
+worker_func (gpointer data,
+             gpointer user_data)
+{
+	WorkerPool *pool = user_data;
+	g_autoptr(GError) error = NULL;
+	gboolean failed;
+
+	g_mutex_lock (&pool->mutex);
+	failed = pool->error != NULL;
+	g_mutex_unlock (&pool->mutex);
+
+	/* Once one item failed there is no point in processing the rest */
+	if (failed)
+		return;
+
+	/* Items are pushed off by one, a thread pool can't queue NULL */
+	if (pool->func (GPOINTER_TO_UINT (data) - 1, pool->user_data, pool->cancellable, &error))
+		return;
+
+	g_mutex_lock (&pool->mutex);
+	if (pool->error == NULL)
+		pool->error = g_steal_pointer (&error);
+	g_mutex_unlock (&pool->mutex);
+
+	/* Stop the items that are already running as well */
+	g_cancellable_cancel (pool->cancellable);
+}
+
+static void
+forward_cancelled_cb (GCancellable *cancellable,
+                      GCancellable *target)
+{
+	g_cancellable_cancel (target);
+}
+
+/**
+ * atsa_worker_pool_run:
+ * @n_items: number of items
+ * @func: called with every index from 0 to @n_items - 1
+ * @user_data: data to pass to @func
+ * @cancellable: (nullable): a #GCancellable
+ * @error: return location for a #GError
+ *
+ * Processes the items in parallel, one worker thread per core, and blocks
+ * until all of them are done. The first item to fail cancels the others
+ * and its error is returned.
+ *
+ * Returns: %TRUE if every item succeeded
+ */
+gboolean
+atsa_worker_pool_run (guint            n_items,
+                      AtsaWorkerFunc   func,
+                      gpointer         user_data,
+                      GCancellable    *cancellable,
+                      GError         **error)
+{
+	WorkerPool pool = { 0 };
+	GThreadPool *thread_pool;
+	gulong cancelled_id = 0;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail (func != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (n_items == 0)
+		return TRUE;
+
+	pool.func = func;
+	pool.user_data = user_data;
+	pool.cancellable = g_cancellable_new ();
+	if (cancellable != NULL)
+		cancelled_id = g_cancellable_connect (cancellable, G_CALLBACK (forward_cancelled_cb),
+		                                      pool.cancellable, NULL);
+	g_mutex_init (&pool.mutex);
+
+	thread_pool = g_thread_pool_new (worker_func, &pool,
+	                                 (int) MIN (g_get_num_processors (), n_items), TRUE, error);
+	if (thread_pool != NULL)
+	{
+		for (guint i = 0; i < n_items; i++)
+			g_thread_pool_push (thread_pool, GUINT_TO_POINTER (i + 1), NULL);
+
+		/* Waits for every queued item */
+		g_thread_pool_free (thread_pool, FALSE, TRUE);
+
+		if (pool.error != NULL)
+			g_propagate_error (error, g_steal_pointer (&pool.error));
+		else
+			ret = TRUE;
+	}
+
+	if (cancellable != NULL)
+		g_cancellable_disconnect (cancellable, cancelled_id);
+	g_object_unref (pool.cancellable);
+	g_mutex_clear (&pool.mutex);
+
+	return ret;
+}
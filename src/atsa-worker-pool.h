@@ -0,0 +1,49 @@
+/* atsa-worker-pool.h
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/**
+ * AtsaWorkerFunc:
+ * @index: the item to process
+ * @user_data: data passed to atsa_worker_pool_run()
+ * @cancellable: cancelled once any item failed or the caller cancelled
+ * @error: return location for a #GError
+ *
+ * Processes one item in a worker thread.
+ *
+ * Returns: %TRUE on success
+ */
+typedef gboolean (*AtsaWorkerFunc) (guint          index,
+                                    gpointer       user_data,
+                                    GCancellable  *cancellable,
+                                    GError       **error);
+
+gboolean atsa_worker_pool_run (guint            n_items,
+                               AtsaWorkerFunc   func,
+                               gpointer         user_data,
+                               GCancellable    *cancellable,
+                               GError         **error);
+
+G_END_DECLS
@@ -0,0 +1,475 @@
+/* test-bank-format.c
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include "atsa-bank-format.h"
+
+/* More than the 64 KiB the readers take in at a time */
+#define LARGE_TEXT_SIZE (200 * 1024)
+
+/* @answer is the letter of the correct choice for multiple choice, one T
+ * or F per statement for true/false. The choices follow, ending in %NULL.
+ */
+static AtsaQuestion *
+question_new (QuestionTypeC  type,
+              const char    *text,
+              const char    *answer,
+              ...)
+{
+	AtsaQuestion *question = g_new0 (AtsaQuestion, 1);
+	g_autoptr(GStrvBuilder) choices = g_strv_builder_new ();
+	const char *choice;
+	va_list args;
+
+	va_start (args, answer);
+	while ((choice = va_arg (args, const char *)) != NULL)
+		g_strv_builder_add (choices, choice);
+	va_end (args);
+
+	question->type = type;
+	question->text = g_strdup (text);
+	question->choices = g_strv_builder_end (choices);
+
+	if (type == QUESTION_TYPE_MULTIPLE_CHOICE)
+	{
+		question->correct_answer = answer[0] - 'A';
+	}
+	else
+	{
+		question->tf_answers = g_new0 (guint8, MAX (strlen (answer), 1));
+		for (guint i = 0; answer[i] != '\0'; i++)
+			question->tf_answers[i] = answer[i] == 'T';
+	}
+
+	return question;
+}
+
+static void
+assert_question_equal (const AtsaQuestion *question,
+                       const AtsaQuestion *expected)
+{
+	g_assert_cmpint (question->type, ==, expected->type);
+	g_assert_cmpstr (question->text, ==, expected->text);
+	g_assert_cmpstrv (question->choices, expected->choices);
+
+	if (expected->type == QUESTION_TYPE_MULTIPLE_CHOICE)
+		g_assert_cmpuint (question->correct_answer, ==, expected->correct_answer);
+	else
+		g_assert_cmpmem (question->tf_answers, g_strv_length (question->choices),
+		                 expected->tf_answers, g_strv_length (expected->choices));
+}
+
+static void
+write_bank (const char     *path,
+            AtsaBankFormat  format,
+            GPtrArray      *questions)
+{
+	g_autoptr(AtsaBankWriter) writer = NULL;
+	g_autoptr(GError) error = NULL;
+
+	writer = atsa_bank_writer_new (path, format, &error);
+	g_assert_no_error (error);
+
+	for (guint i = 0; i < questions->len; i++)
+	{
+		atsa_bank_writer_write (writer, g_ptr_array_index (questions, i), &error);
+		g_assert_no_error (error);
+	}
+
+	atsa_bank_writer_close (writer, &error);
+	g_assert_no_error (error);
+}
+
+static GPtrArray *
+read_bank (const char *path,
+           guint      *n_skipped)
+{
+	g_autoptr(AtsaBankReader) reader = NULL;
+	g_autoptr(GError) error = NULL;
+	GPtrArray *questions = g_ptr_array_new_with_free_func ((GDestroyNotify) atsa_question_free);
+	AtsaQuestion *question;
+
+	reader = atsa_bank_reader_new (path, &error);
+	g_assert_no_error (error);
+
+	while ((question = atsa_bank_reader_next (reader, &error)) != NULL)
+		g_ptr_array_add (questions, question);
+	g_assert_no_error (error);
+
+	if (n_skipped != NULL)
+		*n_skipped = atsa_bank_reader_get_n_skipped (reader);
+
+	return questions;
+}
+
+static void
+assert_bank_equal (GPtrArray *questions,
+                   GPtrArray *expected)
+{
+	g_assert_cmpuint (questions->len, ==, expected->len);
+
+	for (guint i = 0; i < questions->len; i++)
+		assert_question_equal (g_ptr_array_index (questions, i), g_ptr_array_index (expected, i));
+}
+
+static void
+assert_read_error (const char *path,
+                   const char *contents)
+{
+	g_autoptr(AtsaBankReader) reader = NULL;
+	g_autoptr(AtsaQuestion) question = NULL;
+	g_autoptr(GError) error = NULL;
+
+	g_file_set_contents (path, contents, -1, &error);
+	g_assert_no_error (error);
+
+	reader = atsa_bank_reader_new (path, &error);
+	g_assert_no_error (error);
+
+	question = atsa_bank_reader_next (reader, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+	g_assert_null (question);
+}
+
+/* Everything the writers have to quote or escape. True/false questions
+ * have one statement each, GIFT writes every statement as a question of
+ * its own.
+ */
+static GPtrArray *
+tricky_questions (void)
+{
+	GPtrArray *questions = g_ptr_array_new_with_free_func ((GDestroyNotify) atsa_question_free);
+
+	g_ptr_array_add (questions,
+	                 question_new (QUESTION_TYPE_MULTIPLE_CHOICE,
+	                               "Which \"city\", if any,\nis the capital?",
+	                               "B",
+	                               "Lyon, France", "Paris", "\"Quoted\"", NULL));
+	g_ptr_array_add (questions,
+	                 question_new (QUESTION_TYPE_MULTIPLE_CHOICE,
+	                               "[html] is part of the text: {~a =b} # 1 \\ 2",
+	                               "C",
+	                               "a -> b", "%50% of it", "//not a comment", "[markdown]", NULL));
+	g_ptr_array_add (questions,
+	                 question_new (QUESTION_TYPE_TRUE_FALSE,
+	                               "",
+	                               "T",
+	                               "// starts like a comment, ends with a brace }", NULL));
+	g_ptr_array_add (questions,
+	                 question_new (QUESTION_TYPE_TRUE_FALSE,
+	                               "Stem over\ntwo lines",
+	                               "F",
+	                               "[plain] x = y: ~z", NULL));
+
+	return questions;
+}
+
+static void
+test_round_trip (gconstpointer user_data)
+{
+	AtsaBankFormat format = GPOINTER_TO_INT (user_data);
+	g_autoptr(GPtrArray) expected = tricky_questions ();
+	g_autoptr(GPtrArray) questions = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree char *dir = NULL;
+	g_autofree char *name = NULL;
+	g_autofree char *path = NULL;
+
+	dir = g_dir_make_tmp ("atsa-test-XXXXXX", &error);
+	g_assert_no_error (error);
+	name = g_strconcat ("bank.", atsa_bank_format_get_extension (format), NULL);
+	path = g_build_filename (dir, name, NULL);
+
+	write_bank (path, format, expected);
+	questions = read_bank (path, NULL);
+	assert_bank_equal (questions, expected);
+
+	g_assert_cmpint (g_unlink (path), ==, 0);
+	g_assert_cmpint (g_rmdir (dir), ==, 0);
+}
+
+static void
+test_csv (void)
+{
+	g_autoptr(GPtrArray) expected = g_ptr_array_new_with_free_func ((GDestroyNotify) atsa_question_free);
+	g_autoptr(GPtrArray) questions = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree char *dir = NULL;
+	g_autofree char *path = NULL;
+
+	dir = g_dir_make_tmp ("atsa-test-XXXXXX", &error);
+	g_assert_no_error (error);
+	path = g_build_filename (dir, "bank.csv", NULL);
+
+	/* As saved by a spreadsheet: a byte order mark, CRLF line ends, a
+	 * quoted field over several lines and rows padded to the widest one.
+	 * Line ends inside quotes are part of the field, and only the padding
+	 * past the header is dropped.
+	 */
+	g_file_set_contents (path,
+	                     "\xEF\xBB\xBFtype,question,answer,choices,\r\n"
+	                     "mc,\"First line,\r\n"
+	                     "\"\"second\"\" line\r\n"
+	                     "\r\n"
+	                     "after a blank line\",b,one,\"two, and more\",three\r\n"
+	                     "\r\n"
+	                     "tf,Statements,T F,\"Sky is\n"
+	                     "blue\",Grass is red,\r\n",
+	                     -1, &error);
+	g_assert_no_error (error);
+
+	g_ptr_array_add (expected,
+	                 question_new (QUESTION_TYPE_MULTIPLE_CHOICE,
+	                               "First line,\r\n\"second\" line\r\n\r\nafter a blank line",
+	                               "B",
+	                               "one", "two, and more", "three", NULL));
+	g_ptr_array_add (expected,
+	                 question_new (QUESTION_TYPE_TRUE_FALSE,
+	                               "Statements",
+	                               "TF",
+	                               "Sky is\nblue", "Grass is red", NULL));
+
+	questions = read_bank (path, NULL);
+	assert_bank_equal (questions, expected);
+
+	/* Statements are kept together in CSV */
+	g_ptr_array_remove_range (expected, 0, 1);
+	write_bank (path, ATSA_BANK_FORMAT_CSV, expected);
+	g_clear_pointer (&questions, g_ptr_array_unref);
+	questions = read_bank (path, NULL);
+	assert_bank_equal (questions, expected);
+
+	assert_read_error (path, "mc,Unterminated,a,\"b\n");
+	assert_read_error (path, "mc,Question,D,a,b\n");
+	assert_read_error (path, "tf,Question,TT,a\n");
+
+	g_assert_cmpint (g_unlink (path), ==, 0);
+	g_assert_cmpint (g_rmdir (dir), ==, 0);
+}
+
+static void
+test_json (void)
+{
+	g_autoptr(GPtrArray) expected = g_ptr_array_new_with_free_func ((GDestroyNotify) atsa_question_free);
+	g_autoptr(GPtrArray) questions = NULL;
+	g_autoptr(GString) large_text = g_string_new (NULL);
+	g_autoptr(GError) error = NULL;
+	g_autofree char *dir = NULL;
+	g_autofree char *path = NULL;
+
+	dir = g_dir_make_tmp ("atsa-test-XXXXXX", &error);
+	g_assert_no_error (error);
+	path = g_build_filename (dir, "bank.json", NULL);
+
+	/* Braces and quotes inside strings must not end an object, wherever
+	 * the chunks are split.
+	 */
+	while (large_text->len < LARGE_TEXT_SIZE)
+		g_string_append (large_text, "{ \"}\" \\ } ");
+
+	for (guint i = 0; i < 2000; i++)
+	{
+		g_autofree char *text = g_strdup_printf ("Question %u with a } and a \"{\"", i);
+
+		if (i == 1000)
+			g_ptr_array_add (expected,
+			                 question_new (QUESTION_TYPE_MULTIPLE_CHOICE, large_text->str, "A",
+			                               large_text->str, "b", NULL));
+
+		if (i % 2 == 0)
+			g_ptr_array_add (expected,
+			                 question_new (QUESTION_TYPE_MULTIPLE_CHOICE, text, "C",
+			                               "a", "b", "c", NULL));
+		else
+			g_ptr_array_add (expected,
+			                 question_new (QUESTION_TYPE_TRUE_FALSE, text, "FT",
+			                               "x", "y", NULL));
+	}
+
+	write_bank (path, ATSA_BANK_FORMAT_JSON, expected);
+	questions = read_bank (path, NULL);
+	assert_bank_equal (questions, expected);
+
+	assert_read_error (path, "[{\"type\": \"mc\", \"question\": \"Q\", \"choices\": [\"a\", \"b\"], \"answer\": 1.5}]");
+	assert_read_error (path, "[{\"type\": \"mc\", \"question\": \"Q\", \"choices\": [\"a\", \"b\"], \"answer\": \"1\"}]");
+	assert_read_error (path, "[{\"type\": \"mc\", \"question\": \"Q\", \"choices\": [\"a\", \"b\"], \"answer\": 2}]");
+	assert_read_error (path, "[{\"type\": \"mc\", \"question\": \"Q\", \"choices\": [\"a\", \"b\"]");
+
+	g_assert_cmpint (g_unlink (path), ==, 0);
+	g_assert_cmpint (g_rmdir (dir), ==, 0);
+}
+
+static void
+test_gift (void)
+{
+	g_autoptr(GPtrArray) expected = g_ptr_array_new_with_free_func ((GDestroyNotify) atsa_question_free);
+	g_autoptr(GPtrArray) questions = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree char *dir = NULL;
+	g_autofree char *path = NULL;
+	guint n_skipped;
+
+	dir = g_dir_make_tmp ("atsa-test-XXXXXX", &error);
+	g_assert_no_error (error);
+	path = g_build_filename (dir, "bank.gift", NULL);
+
+	g_file_set_contents (path,
+	                     "// A comment\n"
+	                     "$CATEGORY: top/sub\n"
+	                     "\n"
+	                     "::Title\\: with a colon::[html]What is 2 \\= 2\\?\n"
+	                     "{\n"
+	                     "\t=Yes, it \\{is\\}#Right\n"
+	                     "\t~%50%Half -\\> way\n"
+	                     "\t~No\n"
+	                     "}\n"
+	                     "\n"
+	                     "::T/F:: [brackets] stay\n"
+	                     "The sun is cold {FALSE#It's hot}\n"
+	                     "\n"
+	                     "Gandhi's birthday is on {~15th =2nd ~3rd} October.\n"
+	                     "\n"
+	                     "::Matching:: Match {=a -> b =c -> d}\n"
+	                     "\n"
+	                     "::Essay:: Write something {}\n",
+	                     -1, &error);
+	g_assert_no_error (error);
+
+	g_ptr_array_add (expected,
+	                 question_new (QUESTION_TYPE_MULTIPLE_CHOICE,
+	                               "What is 2 = 2?",
+	                               "A",
+	                               "Yes, it {is}", "Half -> way", "No", NULL));
+	g_ptr_array_add (expected,
+	                 question_new (QUESTION_TYPE_TRUE_FALSE,
+	                               "[brackets] stay",
+	                               "F",
+	                               "The sun is cold", NULL));
+	g_ptr_array_add (expected,
+	                 question_new (QUESTION_TYPE_MULTIPLE_CHOICE,
+	                               "Gandhi's birthday is on _____ October.",
+	                               "B",
+	                               "15th", "2nd", "3rd", NULL));
+
+	questions = read_bank (path, &n_skipped);
+	assert_bank_equal (questions, expected);
+	g_assert_cmpuint (n_skipped, ==, 2);
+
+	assert_read_error (path, "::Unterminated title {T}\n");
+	assert_read_error (path, "Question {=a ~b\n");
+
+	g_assert_cmpint (g_unlink (path), ==, 0);
+	g_assert_cmpint (g_rmdir (dir), ==, 0);
+}
+
+static void
+test_convert (void)
+{
+	g_autoptr(GPtrArray) expected = tricky_questions ();
+	g_autoptr(GError) error = NULL;
+	g_autofree char *dir = NULL;
+	g_autofree char *out_dir = NULL;
+	g_autofree char *input = NULL;
+	g_autofree char *broken = NULL;
+	g_autofree char *output = NULL;
+	g_autofree char *broken_output = NULL;
+	g_autofree char *contents = NULL;
+	const char *inputs[3] = { NULL };
+
+	dir = g_dir_make_tmp ("atsa-test-XXXXXX", &error);
+	g_assert_no_error (error);
+	out_dir = g_build_filename (dir, "out", NULL);
+	input = g_build_filename (dir, "bank.csv", NULL);
+	broken = g_build_filename (dir, "broken.csv", NULL);
+	output = g_build_filename (out_dir, "bank.gift", NULL);
+	broken_output = g_build_filename (out_dir, "broken.gift", NULL);
+
+	write_bank (input, ATSA_BANK_FORMAT_CSV, expected);
+	inputs[0] = input;
+
+	atsa_bank_convert_files (inputs, out_dir, ATSA_BANK_FORMAT_GIFT, NULL, &error);
+	g_assert_no_error (error);
+
+	{
+		g_autoptr(GPtrArray) questions = read_bank (output, NULL);
+
+		assert_bank_equal (questions, expected);
+	}
+
+	/* A file that fails halfway leaves an existing output as it was and
+	 * doesn't create a new one.
+	 */
+	g_file_set_contents (broken, "mc,Fine,a,a,b\nunknown,Broken,a,a,b\n", -1, &error);
+	g_assert_no_error (error);
+	inputs[0] = broken;
+
+	g_assert_false (atsa_bank_convert_files (inputs, out_dir, ATSA_BANK_FORMAT_GIFT, NULL, &error));
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+	g_clear_error (&error);
+	g_assert_false (g_file_test (broken_output, G_FILE_TEST_EXISTS));
+
+	g_file_set_contents (broken_output, "previous contents", -1, &error);
+	g_assert_no_error (error);
+	g_assert_false (atsa_bank_convert_files (inputs, out_dir, ATSA_BANK_FORMAT_GIFT, NULL, &error));
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+	g_clear_error (&error);
+
+	g_file_get_contents (broken_output, &contents, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (contents, ==, "previous contents");
+
+	/* Two inputs can't be written to the same file */
+	inputs[0] = input;
+	inputs[1] = input;
+	g_assert_false (atsa_bank_convert_files (inputs, out_dir, ATSA_BANK_FORMAT_GIFT, NULL, &error));
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_EXISTS);
+
+	g_assert_cmpint (g_unlink (input), ==, 0);
+	g_assert_cmpint (g_unlink (broken), ==, 0);
+	g_assert_cmpint (g_unlink (output), ==, 0);
+	g_assert_cmpint (g_unlink (broken_output), ==, 0);
+	g_assert_cmpint (g_rmdir (out_dir), ==, 0);
+	g_assert_cmpint (g_rmdir (dir), ==, 0);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_data_func ("/bank-format/round-trip/csv",
+	                      GINT_TO_POINTER (ATSA_BANK_FORMAT_CSV), test_round_trip);
+	g_test_add_data_func ("/bank-format/round-trip/json",
+	                      GINT_TO_POINTER (ATSA_BANK_FORMAT_JSON), test_round_trip);
+	g_test_add_data_func ("/bank-format/round-trip/gift",
+	                      GINT_TO_POINTER (ATSA_BANK_FORMAT_GIFT), test_round_trip);
+	g_test_add_func ("/bank-format/csv", test_csv);
+	g_test_add_func ("/bank-format/json", test_json);
+	g_test_add_func ("/bank-format/gift", test_gift);
+	g_test_add_func ("/bank-format/convert", test_convert);
+
+	return g_test_run ();
+}
@@ -0,0 +1,322 @@
+/* test-review.c
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include "atsa-due-queue.h"
+#include "atsa-review-store.h"
+
+/* Enough records to make the store double its table twice */
+#define N_RECORDS 2000
+
+static void
+test_due_queue_order (void)
+{
+	g_autoptr(AtsaDueQueue) queue = atsa_due_queue_new ();
+	guint64 hash;
+	gint64 due;
+
+	g_assert_false (atsa_due_queue_peek (queue, &hash, &due));
+
+	atsa_due_queue_set (queue, 1, 300);
+	atsa_due_queue_set (queue, 2, 100);
+	atsa_due_queue_set (queue, 3, 200);
+	/* Ties are broken by hash */
+	atsa_due_queue_set (queue, 5, 100);
+	g_assert_cmpuint (atsa_due_queue_get_size (queue), ==, 4);
+
+	g_assert_true (atsa_due_queue_peek (queue, &hash, &due));
+	g_assert_cmpuint (hash, ==, 2);
+	g_assert_cmpint (due, ==, 100);
+
+	/* Moving a question must not add it twice */
+	atsa_due_queue_set (queue, 2, 400);
+	g_assert_cmpuint (atsa_due_queue_get_size (queue), ==, 4);
+	g_assert_true (atsa_due_queue_peek (queue, &hash, NULL));
+	g_assert_cmpuint (hash, ==, 5);
+
+	atsa_due_queue_set (queue, 1, 50);
+	g_assert_true (atsa_due_queue_peek (queue, &hash, &due));
+	g_assert_cmpuint (hash, ==, 1);
+	g_assert_cmpint (due, ==, 50);
+
+	g_assert_true (atsa_due_queue_remove (queue, 1));
+	g_assert_false (atsa_due_queue_remove (queue, 1));
+	g_assert_true (atsa_due_queue_peek (queue, &hash, NULL));
+	g_assert_cmpuint (hash, ==, 5);
+
+	atsa_due_queue_clear (queue);
+	g_assert_cmpuint (atsa_due_queue_get_size (queue), ==, 0);
+	g_assert_false (atsa_due_queue_peek (queue, &hash, &due));
+}
+
+static void
+test_due_queue_random (void)
+{
+	g_autoptr(AtsaDueQueue) queue = atsa_due_queue_new ();
+	g_autoptr(GHashTable) expected = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, g_free);
+	gint64 last_due = G_MININT64;
+
+	/* Insert, move and remove at random, then drain the queue in order
+	 * and compare with what should be left.
+	 */
+	for (guint i = 0; i < 5000; i++)
+	{
+		guint64 hash = g_test_rand_int_range (1, 500);
+		gint64 due = g_test_rand_int_range (0, 1000);
+
+		if (g_test_rand_int_range (0, 4) == 0)
+		{
+			g_assert_cmpint (atsa_due_queue_remove (queue, hash), ==,
+			                 g_hash_table_remove (expected, &hash));
+		}
+		else
+		{
+			atsa_due_queue_set (queue, hash, due);
+			g_hash_table_insert (expected, g_memdup2 (&hash, sizeof hash), g_memdup2 (&due, sizeof due));
+		}
+	}
+
+	g_assert_cmpuint (atsa_due_queue_get_size (queue), ==, g_hash_table_size (expected));
+
+	while (atsa_due_queue_get_size (queue) > 0)
+	{
+		guint64 hash;
+		gint64 due;
+		gint64 *expected_due;
+
+		g_assert_true (atsa_due_queue_peek (queue, &hash, &due));
+		expected_due = g_hash_table_lookup (expected, &hash);
+		g_assert_nonnull (expected_due);
+		g_assert_cmpint (due, ==, *expected_due);
+		g_assert_cmpint (due, >=, last_due);
+
+		last_due = due;
+		g_assert_true (atsa_due_queue_remove (queue, hash));
+		g_hash_table_remove (expected, &hash);
+	}
+
+	g_assert_cmpuint (g_hash_table_size (expected), ==, 0);
+}
+
+static AtsaReviewRecord
+make_record (guint i)
+{
+	AtsaReviewRecord record = { 0 };
+
+	/* Distinct and never 0, spread over the table with some collisions */
+	record.hash = ((guint64) i + 1) * G_GUINT64_CONSTANT (0x9E3779B97F4A7C15);
+	record.due = 1000 + i;
+	record.interval = i % 365;
+	record.ease = 2500;
+	record.repetitions = i % 7;
+
+	return record;
+}
+
+static void
+assert_all_records (AtsaReviewStore *store)
+{
+	for (guint i = 0; i < N_RECORDS; i++)
+	{
+		AtsaReviewRecord expected = make_record (i);
+		AtsaReviewRecord record;
+
+		g_assert_true (atsa_review_store_lookup (store, expected.hash, &record));
+		g_assert_cmpmem (&record, sizeof record, &expected, sizeof expected);
+	}
+}
+
+static void
+test_review_store (void)
+{
+	g_autoptr(GError) error = NULL;
+	g_autofree char *dir = NULL;
+	g_autofree char *subdir = NULL;
+	g_autofree char *path = NULL;
+	g_autofree char *tmp_path = NULL;
+	AtsaReviewStore *store;
+	AtsaReviewRecord record;
+	GStatBuf st;
+
+	dir = g_dir_make_tmp ("atsa-test-XXXXXX", &error);
+	g_assert_no_error (error);
+	subdir = g_build_filename (dir, "review", NULL);
+	path = g_build_filename (subdir, "state", NULL);
+	tmp_path = g_strconcat (path, ".tmp", NULL);
+
+	/* The parent directory is created as well */
+	store = atsa_review_store_open (path, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (store);
+	g_assert_cmpuint (atsa_review_store_get_n_records (store), ==, 0);
+
+	record = make_record (0);
+	g_assert_false (atsa_review_store_lookup (store, record.hash, &record));
+
+	for (guint i = 0; i < N_RECORDS; i++)
+	{
+		record = make_record (i);
+		g_assert_true (atsa_review_store_put (store, &record, &error));
+		g_assert_no_error (error);
+	}
+
+	g_assert_cmpuint (atsa_review_store_get_n_records (store), ==, N_RECORDS);
+	assert_all_records (store);
+
+	/* Replacing a record doesn't add one */
+	record = make_record (7);
+	record.due = 42;
+	g_assert_true (atsa_review_store_put (store, &record, &error));
+	g_assert_no_error (error);
+	g_assert_cmpuint (atsa_review_store_get_n_records (store), ==, N_RECORDS);
+	record.due = 1007;
+	g_assert_true (atsa_review_store_put (store, &record, &error));
+	g_assert_no_error (error);
+
+	atsa_review_store_close (store);
+
+	/* Growing replaced the file instead of leaving the temporary one */
+	g_assert_false (g_file_test (tmp_path, G_FILE_TEST_EXISTS));
+	g_assert_cmpint (g_stat (path, &st), ==, 0);
+	g_assert_cmpint (st.st_size, >, 32 + 1024 * sizeof (AtsaReviewRecord));
+
+	store = atsa_review_store_open (path, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (store);
+	g_assert_cmpuint (atsa_review_store_get_n_records (store), ==, N_RECORDS);
+	assert_all_records (store);
+
+	record = make_record (N_RECORDS);
+	g_assert_false (atsa_review_store_lookup (store, record.hash, &record));
+
+	atsa_review_store_close (store);
+
+	g_assert_cmpint (g_unlink (path), ==, 0);
+	g_assert_cmpint (g_rmdir (subdir), ==, 0);
+	g_assert_cmpint (g_rmdir (dir), ==, 0);
+}
+
+static void
+test_review_store_invalid (void)
+{
+	g_autoptr(GError) error = NULL;
+	g_autofree char *dir = NULL;
+	g_autofree char *path = NULL;
+	AtsaReviewStore *store;
+
+	dir = g_dir_make_tmp ("atsa-test-XXXXXX", &error);
+	g_assert_no_error (error);
+	path = g_build_filename (dir, "state", NULL);
+
+	g_file_set_contents (path, "not a review state file", -1, &error);
+	g_assert_no_error (error);
+
+	store = atsa_review_store_open (path, &error);
+	g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL);
+	g_assert_null (store);
+
+	g_assert_cmpint (g_unlink (path), ==, 0);
+	g_assert_cmpint (g_rmdir (dir), ==, 0);
+}
+
+/* Writes a store of 1024 slots claiming @n_records, with the first
+ * @n_filled slots taken.
+ */
+static void
+write_store (const char *path,
+             guint64     n_records,
+             guint       n_filled)
+{
+	gsize size = 32 + 1024 * sizeof (AtsaReviewRecord);
+	g_autofree guint8 *contents = g_malloc0 (size);
+	AtsaReviewRecord *records = (AtsaReviewRecord *) (contents + 32);
+	g_autoptr(GError) error = NULL;
+	guint64 capacity = 1024;
+
+	memcpy (contents, "ATSAREV1", 8);
+	memcpy (contents + 8, &capacity, sizeof capacity);
+	memcpy (contents + 16, &n_records, sizeof n_records);
+
+	for (guint i = 0; i < n_filled; i++)
+		records[i].hash = i + 1;
+
+	g_file_set_contents (path, (const char *) contents, size, &error);
+	g_assert_no_error (error);
+}
+
+static void
+test_review_store_damaged (void)
+{
+	g_autoptr(GError) error = NULL;
+	g_autofree char *dir = NULL;
+	g_autofree char *path = NULL;
+	AtsaReviewStore *store;
+	AtsaReviewRecord record;
+
+	dir = g_dir_make_tmp ("atsa-test-XXXXXX", &error);
+	g_assert_no_error (error);
+	path = g_build_filename (dir, "state", NULL);
+
+	/* More records than the table is ever allowed to hold */
+	write_store (path, 1000, 1000);
+	store = atsa_review_store_open (path, &error);
+	g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL);
+	g_assert_null (store);
+	g_clear_error (&error);
+
+	/* A count that doesn't match a completely full table */
+	write_store (path, 0, 1024);
+	store = atsa_review_store_open (path, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (store);
+
+	g_assert_true (atsa_review_store_lookup (store, 1024, &record));
+	g_assert_false (atsa_review_store_lookup (store, 2000, &record));
+
+	record = make_record (0);
+	record.hash = 2000;
+	g_assert_false (atsa_review_store_put (store, &record, &error));
+	g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL);
+
+	atsa_review_store_close (store);
+
+	g_assert_cmpint (g_unlink (path), ==, 0);
+	g_assert_cmpint (g_rmdir (dir), ==, 0);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/due-queue/order", test_due_queue_order);
+	g_test_add_func ("/due-queue/random", test_due_queue_random);
+	g_test_add_func ("/review-store/grow-reopen", test_review_store);
+	g_test_add_func ("/review-store/invalid", test_review_store_invalid);
+	g_test_add_func ("/review-store/damaged", test_review_store_damaged);
+
+	return g_test_run ();
+}
@@ -0,0 +1,113 @@
+/* test-rich-text.c
+ *
+ * Copyright 2025 nam
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include "atsa-rich-text.h"
+
+/* Nested far deeper than any real formula */
+#define DEEP_NESTING 10000
+
+static void
+assert_markup (const char *text,
+               const char *expected)
+{
+	g_autofree char *markup = atsa_rich_text_to_markup (text);
+
+	g_assert_cmpstr (markup, ==, expected);
+}
+
+/* Checks that @text translates to markup Pango accepts and returns its
+ * plain text.
+ */
+static char *
+markup_to_text (const char *text)
+{
+	g_autofree char *markup = atsa_rich_text_to_markup (text);
+	g_autoptr(GError) error = NULL;
+	char *plain = NULL;
+
+	pango_parse_markup (markup, -1, 0, NULL, &plain, NULL, &error);
+	g_assert_no_error (error);
+
+	return plain;
+}
+
+static void
+test_styles (void)
+{
+	assert_markup ("plain <text> & more", "plain &lt;text&gt; &amp; more");
+	assert_markup ("**bold** *italic* `a<b`",
+	               "<b>bold</b> <i>italic</i> <tt>a&lt;b</tt>");
+	assert_markup ("\\*not italic\\*", "*not italic*");
+
+	/* Overlapping and unterminated styles still make well formed markup */
+	assert_markup ("**a *b** c*", "<b>a <i>b** c</i></b>");
+	assert_markup ("*open", "<i>open</i>");
+	assert_markup ("`open", "`open");
+}
+
+static void
+test_math (void)
+{
+	assert_markup ("$x^2 - 1$",
+	               "<span font_family=\"serif\"><i>x</i><sup>2</sup> − 1</span>");
+	assert_markup ("$\\frac{a}{b}$",
+	               "<span font_family=\"serif\"><sup><i>a</i></sup>⁄<sub><i>b</i></sub></span>");
+	assert_markup ("$\\sqrt{2} \\leq \\nope$",
+	               "<span font_family=\"serif\">√<span overline=\"single\">2</span> ≤ \\nope</span>");
+}
+
+static void
+test_math_nesting (void)
+{
+	g_autoptr(GString) groups = g_string_new ("$");
+	g_autoptr(GString) scripts = g_string_new ("$");
+	g_autofree char *groups_text = NULL;
+	g_autofree char *scripts_text = NULL;
+
+	for (guint i = 0; i < DEEP_NESTING; i++)
+	{
+		g_string_append_c (groups, '{');
+		g_string_append (scripts, "x^{");
+	}
+	g_string_append (groups, "x$");
+	g_string_append (scripts, "y$");
+
+	/* Past the depth limit the rest of the formula is shown as typed */
+	groups_text = markup_to_text (groups->str);
+	g_assert_true (g_str_has_suffix (groups_text, "{{{x"));
+
+	scripts_text = markup_to_text (scripts->str);
+	g_assert_true (g_str_has_suffix (scripts_text, "x^{x^{y"));
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/rich-text/styles", test_styles);
+	g_test_add_func ("/rich-text/math", test_math);
+	g_test_add_func ("/rich-text/math-nesting", test_math_nesting);
+
+	return g_test_run ();
+}